@@ -3,23 +3,43 @@
 //  COPYING file in the root directory) and Apache 2.0 License
 //  (found in the LICENSE.Apache file in the root directory).
 
-//#ifdef _WIN32
-#include <Windows.h>
-#include <Psapi.h>
-//#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 #include <cstdio>
+#include <cstring>
+#include <cerrno>
 #include <string>
 #include <random>
 #include <array>
 #include <algorithm>
+#include <numeric>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 
 #include <rocksdb/db.h>
 #include <rocksdb/slice.h>
 #include <rocksdb/options.h>
+#include <rocksdb/statistics.h>
+#include <rocksdb/table.h>
+#include <rocksdb/cache.h>
+#include <rocksdb/iterator.h>
+#include <rocksdb/write_batch.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/merge_operator.h>
+#include <rocksdb/write_buffer_manager.h>
 #include <H5Cpp.h>
 #include <mio/mmap.hpp>
 #include <cereal/archives/binary.hpp>
@@ -30,23 +50,163 @@
 
 #include "timer.h"
 #include "fake.h"
+#include "record_schema.h"
+#include "file_layout.h"
+#include "blob_namespace.h"
+#include "mmap_tuning.h"
+#include "counters.h"
+#include "amplification.h"
+#include "checksum.h"
+#include "dedup.h"
+#include "vectored_io.h"
+#include "hdf5_tuning.h"
+#include "blob_cache.h"
+#include "prefetch.h"
+#include "numa_placement.h"
+#include "socket_ingest.h"
+#include "time_series.h"
+#include "group_log.h"
+#include "worker_pool.h"
 
 using namespace rocksdb;
 using namespace std;
 
 auto logger = spdlog::basic_logger_st("logger", "test.log");
-bool random = false;
+bool random_blobs = false;
+AllocPolicy alloc_policy = AllocPolicy::none;
+BlobNamespace blob_namespace;
+MmapTuning mmap_tuning;
+int nbr_of_threads = 1;
+
+// NUMA placement, -1 leaves threads and memory where the OS puts them
+int numa_node = -1;
+bool numa_spread = false; // Worker threads round robin over all nodes
+
+// Socket ingest, mode is splice, recv or the backend the received blobs go to
+struct IngestTuning
+{
+    string mode{ "splice" };
+    IngestTransport transport{ IngestTransport::tcp };
+} ingest_tuning;
+
+// Soak mode, tests that run for a duration instead of a number of blobs
+struct SoakTuning
+{
+    double duration{ 0.0 }; // Seconds, 0 turns soak mode off
+    double interval{ 1.0 }; // Seconds per row of the time series
+    double stall_ms{ 1000.0 };
+    string backend{ "rocks" };
+    string series_file{ "soak" }; // Prefix of the time series files
+} soak_tuning;
+
+// Number of blobs of the last soak test
+int last_soak_blobs = 0;
+
+// Group commit log of Fake records
+struct LogTuning
+{
+    int records{ 100000 };
+    bool sync{ false };    // Every record waits for its commit
+    int readers{ 1 };      // Threads tailing the log through a mapping
+    int delay_us{ 1000 };  // Longest time a record waits for a batch
+} log_tuning;
+
+// Partial updates, byte ranges of existing blobs overwritten in place
+struct UpdateTuning
+{
+    size_t size{ 4096 };       // Bytes per update
+    int updates{ 0 };          // 0 for ten per blob
+    bool sync{ false };        // Every update is durable before the next starts
+    size_t chunk{ 64 * 1024 }; // RocksDB chunk values, HDF5 chunks and TileDB tiles
+} update_tuning;
+double last_secs_per_blob = 0.0;
+Instrumentation instrumentation;
+CounterSample last_counters;
+bool amp_accounting = false;
+unique_ptr<DeviceStats> device;
+uint64_t device_written_at_start = 0;
+bool verify_blobs = false;
+Timer checksum_timer;
+double checksum_bytes = 0.0;
+int checksum_failures = 0;
+
+// Deduplicating store settings
+struct DedupTuning
+{
+    size_t avg_chunk{ 8192 }; // FastCDC average chunk size
+    int edits{ 16 };          // Edits between two versions of a blob
+    bool rocks{ false };      // Unique chunks in RocksDB instead of a pack file
+} dedup_tuning;
+
+VectoredTuning vectored_tuning;
+
+Hdf5Tuning hdf5_tuning;
+
+// Read cache in front of a backend
+struct CacheTuning
+{
+    string backend{ "file" }; // Backend read on a miss
+    size_t capacity{ 256 * 1024 * 1024 };
+    int shards{ 0 };          // 0 picks a count that holds a few blobs per shard
+    bool admission{ true };   // TinyLFU admission
+    bool compress{ false };   // zlib compressed entries
+    double skew{ 0.99 };      // Zipf skew of the blob requests
+    int reads{ 0 };           // Requests, 0 for ten per blob
+} cache_tuning;
+
+// Readahead of the blobs a sequential reader asks for next
+enum class PrefetchMode { none, threads, fadvise };
+
+struct PrefetchTuning
+{
+    string backend{ "file" };
+    PrefetchMode mode{ PrefetchMode::threads };
+    int depth{ 4 };   // Blobs read ahead
+    int threads{ 2 }; // Background readers in threads mode
+} prefetch_tuning;
+
+// Records of the record tests, written chunk by chunk with record_backend
+using BenchmarkRecords = RecordTypes<Fake, Trade, SensorSample, LogLine>;
+string record_backend{ "c_style" };
+
+// RocksDB settings, the defaults are RocksDB's own
+struct RocksTuning
+{
+    bool string_keys{ false }; // to_string(i) keys, sorts "0", "1", "10", "100"...
+    int cache_mb{ -1 };        // Block cache size, -1 for the default and 0 for none
+    bool hyper_clock{ false }; // HyperClockCache instead of LRUCache
+    size_t readahead{ 0 };     // ReadOptions::readahead_size
+    bool fill_cache{ true };   // ReadOptions::fill_cache
+    bool zero_copy{ false };   // Consume the pinned value instead of copying it to the blob
+} rocks_tuning;
+
+// Memory budget of the run, 0 for none. All RocksDB databases share one
+// block cache of the whole budget, and their memtables are charged to it
+// through a WriteBufferManager of half of it. HDF5 and TileDB caches are
+// capped to a share of the budget.
+struct MemBudget
+{
+    size_t bytes{ 0 };
+    shared_ptr<Cache> cache;
+    shared_ptr<WriteBufferManager> write_buffers;
+} mem_budget;
+
+// Resident set size sampling during a test, 0 only samples at its start and end
+int rss_interval_ms = 20;
+RssSampler rss_sampler;
+
+atomic<uint64_t> consumed{ 0 };
+
+// Number of requests of the last read_cached test
+int last_cached_requests = 0;
 
 const size_t bufsize = 1024 * 1024;
 unique_ptr<char[]> buf(new char[bufsize]);
 
 using Blob = vector<char>;
 
-void fill_blob(Blob& blob)
+void fill_random(Blob& blob)
 {
-    if (!random)
-        return;
-
     random_device rnd;
     default_random_engine eng(rnd());
 
@@ -58,16 +218,30 @@ void fill_blob(Blob& blob)
     });
 }
 
+void fill_blob(Blob& blob)
+{
+    if (random_blobs)
+        fill_random(blob);
+}
+
+// The sequential tests write Fake records, one chunk per field
+auto const& record_chunks(RecordSchema<Fake>::sizes);
+size_t const record_size(RecordSchema<Fake>::size);
+
+// Number of records write_chunks and read_chunks do for a blob
+template<class Record = Fake>
+size_t records_per_blob(size_t blob_size)
+{
+    return blob_size > RecordSchema<Record>::size ? (blob_size - 1) / RecordSchema<Record>::size : 0;
+}
+
+template<class Record = Fake>
 void write_chunks(size_t index, Timer& timer, function<void(Blob const &)> const writer)
 {
-    static Blob chunk1(96, '1');
-    static Blob chunk2(90, '2');
-    static Blob chunk3(96, '3');
-    static Blob chunk4(60, '4');
-    static array<Blob, 4> chunks{ chunk1, chunk2, chunk3, chunk4 };
-    static size_t const chunks_size(96 + 90 + 96 + 60);
+    static auto chunks(make_record_chunks<Record>());
+    size_t const chunks_size(RecordSchema<Record>::size);
     
-    if (random)
+    if (random_blobs)
     {
         while (index > chunks_size)
         {
@@ -89,14 +263,11 @@ void write_chunks(size_t index, Timer& timer, function<void(Blob const &)> const
     }
 }
 
+template<class Record = Fake>
 void read_chunks(size_t index, function<void(Blob&)> const reader)
 {
-    static Blob chunk1(96);
-    static Blob chunk2(90);
-    static Blob chunk3(96);
-    static Blob chunk4(60);
-    static array<Blob, 4> chunks{ chunk1, chunk2, chunk3, chunk4 };
-    static size_t const chunks_size(96 + 90 + 96 + 60);
+    static auto chunks(make_record_chunks<Record>());
+    size_t const chunks_size(RecordSchema<Record>::size);
     while (index > chunks_size)
     {
         for_each(chunks.begin(), chunks.end(), reader);
@@ -104,31 +275,302 @@ void read_chunks(size_t index, function<void(Blob&)> const reader)
     }
 }
 
-double write_rocks(Blob& blob, int count, string file_name)
+// End-to-end verification, the writers store a CRC32C per blob in
+// file_name.crc32c and the readers check what they read against it. The
+// checksum time is part of the test time and also reported on its own.
+void record_checksum(vector<uint32_t>& sums, Blob const& blob)
+{
+    if (!verify_blobs)
+        return;
+
+    checksum_timer.start();
+    sums.push_back(crc32c(blob.data(), blob.size()));
+    checksum_timer.stop();
+    checksum_bytes += blob.size();
+}
+
+void save_checksums(string const& file_name, vector<uint32_t> const& sums)
+{
+    if (verify_blobs)
+        save_checksum_file(file_name + ".crc32c", sums);
+}
+
+vector<uint32_t> load_checksums(string const& file_name)
+{
+    if (!verify_blobs)
+        return vector<uint32_t>();
+
+    auto sums(load_checksum_file(file_name + ".crc32c"));
+    if (sums.empty())
+        cout << "No checksums in " << file_name << ".crc32c, not verifying, run the write test with --verify first" << endl;
+    return sums;
+}
+
+// Without checksums load_checksums already warned, nothing is verified
+void verify_checksum(vector<uint32_t> const& sums, size_t i, char const* data, size_t size)
+{
+    if (!verify_blobs || sums.empty())
+        return;
+
+    checksum_timer.start();
+    auto const crc(crc32c(data, size));
+    checksum_timer.stop();
+    checksum_bytes += size;
+    if (i >= sums.size() || sums[i] != crc)
+        ++checksum_failures;
+}
+
+void verify_checksum(vector<uint32_t> const& sums, size_t i, Blob const& blob)
+{
+    verify_checksum(sums, i, blob.data(), blob.size());
+}
+
+string blob_name(string const& file_name, int i, string const& suffix = "")
+{
+    return blob_namespace.name(file_name, i, suffix);
+}
+
+// Pin worker thread number worker as --numa and --numa-spread ask
+void pin_worker(int worker)
+{
+    if (numa_spread)
+        pin_thread_to_node(worker % numa_nodes());
+    else if (numa_node >= 0)
+        pin_thread_to_node(numa_node);
+}
+
+// Run body(begin, end) on nbr_of_threads threads, each taking a slice of [0, count)
+void run_threads(int count, function<void(int, int)> const& body)
+{
+    vector<thread> threads;
+    auto const per_thread((count + nbr_of_threads - 1) / nbr_of_threads);
+    auto worker(0);
+    for (auto begin(0); begin < count; begin += per_thread, ++worker)
+    {
+        threads.emplace_back([&body, begin, end = min(begin + per_thread, count), worker]
+        {
+            pin_worker(worker);
+            body(begin, end);
+        });
+    }
+    for_each(threads.begin(), threads.end(), [](thread& t) { t.join(); });
+}
+
+// Reserve space for a blob file according to alloc_policy
+bool prepare_blob_file(string const& name, size_t size, bool set_size = false)
+{
+    if (alloc_policy == AllocPolicy::none && !set_size)
+        return true;
+
+    error_code error;
+    prepare_file(name, size, alloc_policy, set_size, error);
+    if (error)
+    {
+        cout << error.message();
+        return false;
+    }
+    return true;
+}
+
+// A prepared file must not be truncated when it is opened for writing
+ios::openmode stream_write_mode()
+{
+    return alloc_policy == AllocPolicy::none ? ios::binary | ios::trunc : ios::binary | ios::in | ios::out;
+}
+
+char const* c_style_write_mode()
+{
+    return alloc_policy == AllocPolicy::none ? "wb" : "r+b";
+}
+
+// Fixed width big endian keys so the key order is the blob order
+string rocks_key(uint64_t i)
+{
+    if (rocks_tuning.string_keys)
+        return to_string(i);
+
+    string key(sizeof(i), '\0');
+    for (auto b(sizeof(i)); b != 0; --b, i >>= 8)
+        key[b - 1] = static_cast<char>(i & 0xff);
+    return key;
+}
+
+BlockBasedTableOptions rocks_table_options()
+{
+    BlockBasedTableOptions table_options;
+    if (mem_budget.cache)
+    {
+        // Index and filter blocks count against the budget too
+        table_options.block_cache = mem_budget.cache;
+        table_options.cache_index_and_filter_blocks = true;
+        table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+        return table_options;
+    }
+    if (rocks_tuning.cache_mb >= 0)
+    {
+        size_t const capacity(size_t(rocks_tuning.cache_mb) * 1048576);
+        if (capacity == 0)
+            table_options.no_block_cache = true;
+        else if (rocks_tuning.hyper_clock)
+            // An estimated entry charge of 0 sizes the table automatically (RocksDB 8.0+)
+            table_options.block_cache = HyperClockCacheOptions(capacity, 0).MakeSharedCache();
+        else
+            table_options.block_cache = NewLRUCache(capacity);
+    }
+    return table_options;
+}
+
+Options rocks_options()
 {
-    DB* db;
     Options options;
     // Optimize RocksDB. This is the easiest way to get RocksDB to perform well
     options.IncreaseParallelism();
     options.OptimizeLevelStyleCompaction();
-    // create the DB if it's not already present
+    if (mem_budget.write_buffers)
+    {
+        // OptimizeLevelStyleCompaction sizes the memtables for 512MB
+        options.write_buffer_manager = mem_budget.write_buffers;
+        options.write_buffer_size = max<size_t>(1048576, mem_budget.bytes / 8);
+    }
+    options.table_factory.reset(NewBlockBasedTableFactory(rocks_table_options()));
+    return options;
+}
+
+// Applies a memory budget to RocksDB and caps the HDF5 caches of the
+// unbudgeted settings hdf5 to it
+void set_mem_budget(size_t bytes, Hdf5Tuning const& hdf5)
+{
+    mem_budget = MemBudget();
+    hdf5_tuning = hdf5;
+    if (bytes == 0)
+        return;
+
+    mem_budget.bytes = bytes;
+    mem_budget.cache = NewLRUCache(bytes);
+    // Writes stall rather than grow the memtables past their share
+    mem_budget.write_buffers = make_shared<WriteBufferManager>(bytes / 2, mem_budget.cache, true);
+
+    hdf5_tuning.meta_cache_max = bytes / 8;
+    hdf5_tuning.meta_cache = min(hdf5_tuning.meta_cache, bytes / 8);
+    hdf5_tuning.chunk_cache = min(hdf5_tuning.chunk_cache, bytes / 4);
+    hdf5_tuning.page_buffer = min(hdf5_tuning.page_buffer, bytes / 8);
+}
+
+tiledb::Config tiledb_config()
+{
+    tiledb::Config config;
+    if (mem_budget.bytes != 0)
+    {
+        // The first two are for the readers before TileDB 2.5, the last for the ones after
+        config["sm.memory_budget"] = to_string(mem_budget.bytes / 8);
+        config["sm.memory_budget_var"] = to_string(mem_budget.bytes / 8);
+        config["sm.mem.total_budget"] = to_string(mem_budget.bytes / 4);
+    }
+    return config;
+}
+
+ReadOptions rocks_read_options()
+{
+    ReadOptions read_options;
+    read_options.readahead_size = rocks_tuning.readahead;
+    read_options.fill_cache = rocks_tuning.fill_cache;
+    return read_options;
+}
+
+// Read every word of a value where it is, the zero-copy alternative to copying it
+uint64_t consume(char const* data, size_t size)
+{
+    uint64_t sum(0), word;
+    size_t i(0);
+    for (; i + sizeof(word) <= size; i += sizeof(word))
+    {
+        memcpy(&word, data + i, sizeof(word));
+        sum += word;
+    }
+    for (; i != size; ++i)
+        sum += static_cast<unsigned char>(data[i]);
+    return sum;
+}
+
+// A value is still copied with copy set, for checksums over a whole chunked blob
+void use_value(Blob& blob, Slice const& value, size_t offset = 0, bool copy = false)
+{
+    if (rocks_tuning.zero_copy && !copy)
+        consumed += consume(value.data(), value.size());
+    else if (offset < blob.size())
+        memcpy(blob.data() + offset, value.data(), min(blob.size() - offset, value.size()));
+}
+
+// Wait until a column family has no compactions pending or running, false
+// when RocksDB can't tell
+bool wait_for_compactions(DB* db, ColumnFamilyHandle* family)
+{
+    for (;;)
+    {
+        uint64_t pending(0), running(0);
+        if (!db->GetIntProperty(family, "rocksdb.compaction-pending", &pending)
+            || !db->GetIntProperty("rocksdb.num-running-compactions", &running))
+            return false;
+        if (pending == 0 && running == 0)
+            return true;
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+}
+
+// RocksDB's own write amplification of a write test. The memtable is flushed
+// and the background compactions finish first so all their bytes are counted.
+void print_rocks_amp(DB* db, ColumnFamilyHandle* family, Statistics const& stats, string const& msg)
+{
+    auto const s(db->Flush(FlushOptions(), family));
+    if (!s.ok() || !wait_for_compactions(db, family))
+        cout << "Flush or compaction state failed, the RocksDB write-amp is incomplete " << s.ToString() << endl;
+
+    auto const user(stats.getTickerCount(BYTES_WRITTEN));
+    auto const wal(stats.getTickerCount(WAL_FILE_BYTES));
+    auto const flush(stats.getTickerCount(FLUSH_WRITE_BYTES));
+    auto const compact(stats.getTickerCount(COMPACT_WRITE_BYTES));
+    spdlog::info("{:7.1f}MB user, {:7.1f}MB wal, {:7.1f}MB flush, {:7.1f}MB compaction, rocks write-amp {:5.2f} :{}",
+        user / 1048576.0, wal / 1048576.0, flush / 1048576.0, compact / 1048576.0,
+        user != 0 ? double(wal + flush + compact) / user : 0.0, msg);
+}
+
+double write_rocks(Blob& blob, int count, string file_name)
+{
+    DB* db;
+    Options options(rocks_options());
+    // Start from an empty DB, the footprint must not include earlier runs
+    error_code error;
+    filesystem::remove_all(file_name, error);
     options.create_if_missing = true;
+    if (amp_accounting)
+        options.statistics = CreateDBStatistics();
 
     // open DB
     Status s = DB::Open(options, file_name, &db);
+    if (!s.ok())
+    {
+        cout << s.ToString();
+        return 0.0;
+    }
 
     Timer timer;
+    vector<uint32_t> sums;
         
     // Put key-value one by one
     for (auto i(0); i != count; ++i)
     {
         fill_blob(blob);
         timer.start();
-        s = db->Put(WriteOptions(), to_string(i), Slice(blob.data(), blob.size()));
+        s = db->Put(WriteOptions(), rocks_key(i), Slice(blob.data(), blob.size()));
+        record_checksum(sums, blob);
         timer.stop();
         cout << '#';
     }
     cout << endl;
+    save_checksums(file_name, sums);
+
+    if (amp_accounting)
+        print_rocks_amp(db, db->DefaultColumnFamily(), *options.statistics, "write_rocks");
 
     delete db;
 
@@ -138,14 +580,18 @@ double write_rocks(Blob& blob, int count, string file_name)
 double read_rocks(Blob& blob, int count, string file_name)
 {
     DB* db;
-    Options options;
-    // Optimize RocksDB. This is the easiest way to get RocksDB to perform well
-    options.IncreaseParallelism();
-    options.OptimizeLevelStyleCompaction();
+    Options options(rocks_options());
 
     // open DB
     Status s = DB::Open(options, file_name, &db);
+    if (!s.ok())
+    {
+        cout << s.ToString();
+        return 0.0;
+    }
 
+    auto const read_options(rocks_read_options());
+    auto const sums(load_checksums(file_name));
     Timer timer;
 
     // Get key-value one by one
@@ -153,7 +599,18 @@ double read_rocks(Blob& blob, int count, string file_name)
     {
         PinnableSlice pinnable_val;
         timer.start();
-        s = db->Get(ReadOptions(), db->DefaultColumnFamily(), to_string(i), &pinnable_val);
+        s = db->Get(read_options, db->DefaultColumnFamily(), rocks_key(i), &pinnable_val);
+        if (!s.ok())
+        {
+            cout << s.ToString();
+            delete db;
+            return 0.0;
+        }
+        use_value(blob, pinnable_val);
+        if (rocks_tuning.zero_copy)
+            verify_checksum(sums, i, pinnable_val.data(), pinnable_val.size());
+        else
+            verify_checksum(sums, i, blob);
         timer.stop();
         cout << '#';
     }
@@ -164,62 +621,215 @@ double read_rocks(Blob& blob, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double write_file_stream(Blob& blob, int count, string file_name)
+// Range scan with one iterator, in key order from the first blob
+double scan_rocks(Blob& blob, int count, string file_name)
 {
+    DB* db;
+    Options options(rocks_options());
+
+    // open DB
+    Status s = DB::Open(options, file_name, &db);
+    if (!s.ok())
+    {
+        cout << s.ToString();
+        return 0.0;
+    }
+
+    auto const sums(load_checksums(file_name));
     Timer timer;
-    for (auto i(0); i != count; ++i)
+    timer.start();
+    unique_ptr<Iterator> it(db->NewIterator(rocks_read_options()));
+    auto n(0);
+    for (it->Seek(rocks_key(0)); it->Valid() && n != count; it->Next(), ++n)
     {
-        auto name = file_name + to_string(i);
-        fill_blob(blob);
-        timer.start();
-        auto myfile = ofstream(name, ios::binary);
-        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
-        myfile.write(blob.data(), blob.size());
-        myfile.close();
-        timer.stop();
+        use_value(blob, it->value());
+        if (rocks_tuning.zero_copy)
+            verify_checksum(sums, n, it->value().data(), it->value().size());
+        else
+            verify_checksum(sums, n, blob);
         cout << '#';
     }
+    s = it->status();
+    it.reset();
+    timer.stop();
     cout << endl;
+
+    delete db;
+
+    if (!s.ok() || n != count)
+    {
+        cout << "Scanned " << n << " of " << count << " blobs " << s.ToString() << endl;
+        return 0.0;
+    }
     return timer.elapsedSeconds();
 }
 
-double read_file_stream(Blob& blob, int count, string file_name)
+// Patches a chunk in place, an operand is the 8 byte offset of the patch in
+// the chunk followed by the bytes that go there
+class PatchMergeOperator : public MergeOperator
+{
+public:
+    bool FullMergeV2(MergeOperationInput const& merge_in, MergeOperationOutput* merge_out) const override
+    {
+        auto& value(merge_out->new_value);
+        if (merge_in.existing_value)
+            value.assign(merge_in.existing_value->data(), merge_in.existing_value->size());
+        else
+            value.clear();
+        for (auto const& operand : merge_in.operand_list)
+        {
+            uint64_t offset;
+            if (operand.size() < sizeof(offset))
+                return false;
+            memcpy(&offset, operand.data(), sizeof(offset));
+            auto const size(operand.size() - sizeof(offset));
+            if (value.size() < offset + size)
+                value.resize(offset + size);
+            memcpy(&value[offset], operand.data() + sizeof(offset), size);
+        }
+        return true;
+    }
+
+    char const* Name() const override { return "PatchMergeOperator"; }
+};
+
+// Chunked layout, blob i is split in chunks stored under "blob id/chunk no"
+// keys in their own column family so no single value outgrows the memtable
+string chunk_key(uint64_t blob, uint32_t chunk)
+{
+    string key(sizeof(blob) + sizeof(chunk), '\0');
+    for (auto b(sizeof(blob)); b != 0; --b, blob >>= 8)
+        key[b - 1] = static_cast<char>(blob & 0xff);
+    for (auto b(key.size()); b != sizeof(blob); --b, chunk >>= 8)
+        key[b - 1] = static_cast<char>(chunk & 0xff);
+    return key;
+}
+
+struct ChunkedRocks
+{
+    ~ChunkedRocks()
+    {
+        for_each(handles.begin(), handles.end(), [this](ColumnFamilyHandle* h) { db->DestroyColumnFamilyHandle(h); });
+        delete db;
+    }
+
+    ColumnFamilyHandle* chunks() const { return handles[1]; }
+
+    DB* db{ nullptr };
+    vector<ColumnFamilyHandle*> handles;
+    shared_ptr<Statistics> statistics; // With --amp
+};
+
+Status open_chunked_rocks(string const& file_name, ChunkedRocks& rocks, shared_ptr<MergeOperator> merge_operator = nullptr)
+{
+    Options options(rocks_options());
+    options.create_if_missing = true;
+    options.create_missing_column_families = true;
+    if (amp_accounting)
+        options.statistics = rocks.statistics = CreateDBStatistics();
+
+    // All chunks of a blob share the blob id as prefix, the bloom filters
+    // are built on that prefix
+    ColumnFamilyOptions chunk_options(options);
+    chunk_options.prefix_extractor.reset(NewFixedPrefixTransform(sizeof(uint64_t)));
+    chunk_options.merge_operator = merge_operator;
+    auto table_options(rocks_table_options());
+    table_options.filter_policy.reset(NewBloomFilterPolicy(10));
+    chunk_options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+    vector<ColumnFamilyDescriptor> families{
+        ColumnFamilyDescriptor(kDefaultColumnFamilyName, ColumnFamilyOptions(options)),
+        ColumnFamilyDescriptor("chunks", chunk_options) };
+    return DB::Open(options, file_name, families, &rocks.handles, &rocks.db);
+}
+
+double write_rocks_chunked(Blob& blob, int count, string file_name, size_t chunk_size)
 {
+    // Start from an empty DB, the footprint must not include earlier runs
+    error_code error;
+    filesystem::remove_all(file_name, error);
+    ChunkedRocks rocks;
+    Status s = open_chunked_rocks(file_name, rocks);
+    if (!s.ok())
+    {
+        cout << s.ToString();
+        return 0.0;
+    }
+
     Timer timer;
+    vector<uint32_t> sums;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        fill_blob(blob);
         timer.start();
-        auto myfile = ifstream(name, ios::binary);
-        myfile.read(blob.data(), blob.size());
-        myfile.close();
+        WriteBatch batch;
+        for (size_t offset(0), c(0); offset < blob.size(); offset += chunk_size, ++c)
+        {
+            batch.Put(rocks.chunks(), chunk_key(i, c), Slice(blob.data() + offset, min(chunk_size, blob.size() - offset)));
+        }
+        s = rocks.db->Write(WriteOptions(), &batch);
+        record_checksum(sums, blob);
         timer.stop();
+        if (!s.ok())
+        {
+            cout << s.ToString();
+            return 0.0;
+        }
         cout << '#';
     }
     cout << endl;
+    save_checksums(file_name, sums);
+    if (rocks.statistics)
+        print_rocks_amp(rocks.db, rocks.chunks(), *rocks.statistics, "write_rocks_chunked_" + to_string(chunk_size / 1024) + "KB");
     return timer.elapsedSeconds();
 }
 
-double seq_write_file_stream(size_t blob_size, int count, string file_name)
+// The chunks of a blob are fetched with one MultiGet per thread of a pool
+// that is started before the timer
+double read_rocks_chunked(Blob& blob, int count, string file_name, size_t chunk_size)
 {
-    struct Writer
+    ChunkedRocks rocks;
+    Status s = open_chunked_rocks(file_name, rocks);
+    if (!s.ok())
     {
-        Writer(ofstream& ofs) : m_ofs(ofs) {}
-        void write(Blob const& blob) const { m_ofs.write(blob.data(), blob.size()); }
-        ofstream& m_ofs;
-    };
+        cout << s.ToString();
+        return 0.0;
+    }
 
-    using std::placeholders::_1;
+    auto const nbr_of_chunks(static_cast<int>((blob.size() + chunk_size - 1) / chunk_size));
+    auto const read_options(rocks_read_options());
+    atomic<int> failures{ 0 };
+    auto const sums(load_checksums(file_name));
+    WorkerPool pool(nbr_of_threads, pin_worker);
 
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        vector<string> keys(nbr_of_chunks);
+        for (auto c(0); c != nbr_of_chunks; ++c)
+            keys[c] = chunk_key(i, c);
+
         timer.start();
-        auto myfile = ofstream(name, ios::binary);
-        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
-        write_chunks(blob_size, timer, bind(&Writer::write, Writer(myfile), _1));
-        myfile.close();
+        pool.run(nbr_of_chunks, [&](int begin, int end)
+        {
+            vector<Slice> slices(keys.begin() + begin, keys.begin() + end);
+            vector<PinnableSlice> values(slices.size());
+            vector<Status> statuses(slices.size());
+            rocks.db->MultiGet(read_options, rocks.chunks(), slices.size(), slices.data(), values.data(), statuses.data(), true);
+            for (size_t k(0); k != slices.size(); ++k)
+            {
+                if (statuses[k].ok())
+                    use_value(blob, values[k], (begin + k) * chunk_size, verify_blobs);
+                else
+                    ++failures;
+            }
+        });
+        if (failures != 0)
+        {
+            cout << failures << " chunks of blob " << i << " not found" << endl;
+            return 0.0;
+        }
+        verify_checksum(sums, i, blob);
         timer.stop();
         cout << '#';
     }
@@ -227,44 +837,153 @@ double seq_write_file_stream(size_t blob_size, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double seq_read_file_stream(size_t blob_size, int count, string file_name)
+// Make the blob the next version of itself, edits moves a few short ranges
+// of bytes to other places and overwrites them with new bytes
+void mutate_blob(Blob& blob, int edits)
 {
-    struct Reader
+    if (blob.empty())
+        return;
+
+    random_device rnd;
+    default_random_engine eng(rnd());
+    uniform_int_distribution<size_t> pos(0, blob.size() - 1);
+    uniform_int_distribution<size_t> len(1, 64);
+    uniform_int_distribution<> byte(0, 255);
+
+    for (auto e(0); e != edits; ++e)
     {
-        Reader(ifstream& ifs) : m_ifs(ifs) {}
-        void read(Blob& blob) const { m_ifs.read(blob.data(), blob.size()); }
-        ifstream& m_ifs;
-    };
+        auto const n(min(len(eng), blob.size() / 2));
+        auto const from(min(pos(eng), blob.size() - n));
+        blob.erase(blob.begin() + from, blob.begin() + from + n);
+        auto const to(min(pos(eng), blob.size()));
+        Blob inserted(n);
+        generate(inserted.begin(), inserted.end(), [&] { return static_cast<char>(byte(eng)); });
+        blob.insert(blob.begin() + to, inserted.begin(), inserted.end());
+    }
+}
 
-    using std::placeholders::_1;
+struct DedupStats
+{
+    uint64_t logical{ 0 };
+    uint64_t stored{ 0 };
+    size_t chunks{ 0 };
+    size_t unique{ 0 };
+    Timer chunk_timer;
+    Timer hash_timer;
+};
+
+void print_dedup(DedupStats& stats, string const& msg)
+{
+    auto const chunk_secs(stats.chunk_timer.elapsedSeconds());
+    auto const hash_secs(stats.hash_timer.elapsedSeconds());
+    spdlog::info("dedup ratio {:6.2f}, {} of {} chunks unique, avg {:.0f}B, chunking {:6.2f}GB/s, hashing {:6.2f}GB/s :{}",
+        stats.stored != 0 ? double(stats.logical) / stats.stored : 0.0, stats.unique, stats.chunks,
+        stats.chunks != 0 ? double(stats.logical) / stats.chunks : 0.0,
+        chunk_secs > 0 ? stats.logical / 1e9 / chunk_secs : 0.0, hash_secs > 0 ? stats.logical / 1e9 / hash_secs : 0.0, msg);
+}
 
+// Every blob is a new version of the one before. The blobs are split with
+// FastCDC, unique chunks are appended to file_name + "pack" and each blob
+// keeps a manifest of its chunks in file_name + "manifest". The versions are
+// built in a local blob that starts random even without -r, constant bytes
+// give FastCDC no content to find cut points in.
+double write_dedup_pack(Blob& blob, int count, string file_name)
+{
+    FastCdc const cdc(dedup_tuning.avg_chunk);
+    DedupStats stats;
+    unordered_map<Fingerprint, ChunkRef, FingerprintHash> index;
+    vector<vector<ChunkRef>> manifests(count);
+
+    Blob version(blob.size());
     Timer timer;
+    vector<uint32_t> sums;
+    timer.start();
+    FILE* pack = fopen((file_name + "pack").c_str(), "wb");
+    timer.stop();
+    if (pack == nullptr)
+    {
+        cout << strerror(errno);
+        return 0.0;
+    }
+
+    uint64_t pack_size(0);
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        if (i == 0)
+            fill_random(version);
+        else
+            mutate_blob(version, dedup_tuning.edits);
         timer.start();
-        auto myfile = ifstream(name, ios::binary);
-        read_chunks(blob_size, bind(&Reader::read, Reader(myfile), _1));
-        myfile.close();
+        vector<pair<size_t, size_t>> cuts;
+        stats.chunk_timer.start();
+        cdc.split(version.data(), version.size(), [&](size_t offset, size_t length) { cuts.emplace_back(offset, length); });
+        stats.chunk_timer.stop();
+        for (auto const& cut : cuts)
+        {
+            stats.hash_timer.start();
+            auto const fp(fingerprint(version.data() + cut.first, cut.second));
+            stats.hash_timer.stop();
+            auto found = index.find(fp);
+            if (found == index.end())
+            {
+                fwrite(version.data() + cut.first, 1, cut.second, pack);
+                found = index.emplace(fp, ChunkRef{ pack_size, static_cast<uint32_t>(cut.second) }).first;
+                pack_size += cut.second;
+                ++stats.unique;
+            }
+            manifests[i].push_back(found->second);
+        }
+        stats.chunks += cuts.size();
+        stats.logical += version.size();
+        record_checksum(sums, version);
         timer.stop();
         cout << '#';
     }
+    timer.start();
+    fclose(pack);
+    save_manifests(file_name + "manifest", manifests);
+    timer.stop();
     cout << endl;
+    save_checksums(file_name, sums);
+
+    stats.stored = pack_size;
+    print_dedup(stats, "write_dedup");
     return timer.elapsedSeconds();
 }
 
-
-double write_c_style_io(Blob& blob, int count, string file_name)
+double read_dedup_pack(Blob& blob, int count, string file_name)
 {
+    auto const sums(load_checksums(file_name));
+
     Timer timer;
+    timer.start();
+    auto const manifests(load_manifests(file_name + "manifest"));
+    ifstream pack(file_name + "pack", ios::binary);
+    timer.stop();
+    if (!pack || manifests.size() < size_t(count))
+    {
+        cout << "No dedup store in " << file_name << endl;
+        return 0.0;
+    }
+
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
-        fill_blob(blob);
         timer.start();
-        FILE* file = fopen(name.c_str(), "wb");
-        fwrite(blob.data(), 1, blob.size(), file);
-        fclose(file);
+        size_t cursor(0);
+        for (auto const& ref : manifests[i])
+        {
+            if (cursor + ref.size > blob.size())
+                break;
+            pack.seekg(ref.offset);
+            pack.read(blob.data() + cursor, ref.size);
+            cursor += ref.size;
+        }
+        if (!pack || cursor != blob.size())
+        {
+            cout << "Failed to reconstruct blob " << i << endl;
+            return 0.0;
+        }
+        verify_checksum(sums, i, blob);
         timer.stop();
         cout << '#';
     }
@@ -272,109 +991,194 @@ double write_c_style_io(Blob& blob, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double read_c_style_io(Blob& blob, int count, string file_name)
+// Same as the pack store but the unique chunks are stored in RocksDB under
+// 'c' + fingerprint and the manifests under 'm' + blob key
+string dedup_chunk_key(Fingerprint const& fp)
+{
+    string key(1 + sizeof(fp), 'c');
+    memcpy(&key[1], &fp, sizeof(fp));
+    return key;
+}
+
+double write_dedup_rocks(Blob& blob, int count, string file_name)
 {
+    DB* db;
+    Options options(rocks_options());
+    options.create_if_missing = true;
+
+    Status s = DB::Open(options, file_name + "rocks", &db);
+    if (!s.ok())
+    {
+        cout << s.ToString();
+        return 0.0;
+    }
+
+    FastCdc const cdc(dedup_tuning.avg_chunk);
+    DedupStats stats;
+    unordered_set<Fingerprint, FingerprintHash> stored;
+
+    Blob version(blob.size());
     Timer timer;
+    vector<uint32_t> sums;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        if (i == 0)
+            fill_random(version);
+        else
+            mutate_blob(version, dedup_tuning.edits);
         timer.start();
-        FILE* file = fopen(name.c_str(), "rb");
-        fread(blob.data(), 1, blob.size(), file);
-        fclose(file);
+        WriteBatch batch;
+        string manifest;
+        vector<pair<size_t, size_t>> cuts;
+        stats.chunk_timer.start();
+        cdc.split(version.data(), version.size(), [&](size_t offset, size_t length) { cuts.emplace_back(offset, length); });
+        stats.chunk_timer.stop();
+        for (auto const& cut : cuts)
+        {
+            stats.hash_timer.start();
+            auto const fp(fingerprint(version.data() + cut.first, cut.second));
+            stats.hash_timer.stop();
+            if (stored.insert(fp).second)
+            {
+                batch.Put(dedup_chunk_key(fp), Slice(version.data() + cut.first, cut.second));
+                stats.stored += cut.second;
+                ++stats.unique;
+            }
+            manifest.append(reinterpret_cast<char const*>(&fp), sizeof(fp));
+        }
+        batch.Put("m" + rocks_key(i), manifest);
+        s = db->Write(WriteOptions(), &batch);
+        stats.chunks += cuts.size();
+        stats.logical += version.size();
+        record_checksum(sums, version);
         timer.stop();
+        if (!s.ok())
+        {
+            cout << s.ToString();
+            delete db;
+            return 0.0;
+        }
         cout << '#';
     }
     cout << endl;
+    save_checksums(file_name, sums);
+
+    delete db;
+
+    print_dedup(stats, "write_dedup");
     return timer.elapsedSeconds();
 }
 
-double seq_write_c_style_io(size_t blob_size, int count, string file_name)
+double read_dedup_rocks(Blob& blob, int count, string file_name)
 {
-    struct Writer
+    DB* db;
+    Options options(rocks_options());
+
+    Status s = DB::Open(options, file_name + "rocks", &db);
+    if (!s.ok())
     {
-        Writer(FILE* file) : m_file(file) {}
-        void write(Blob const& blob) const { fwrite(blob.data(), 1, blob.size(), m_file); }
-        FILE* m_file;
-    };
+        cout << s.ToString();
+        return 0.0;
+    }
 
-    using std::placeholders::_1;
+    auto const read_options(rocks_read_options());
+    auto const sums(load_checksums(file_name));
 
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
         timer.start();
-        FILE* file = fopen(name.c_str(), "wb");
-        write_chunks(blob_size, timer, bind(&Writer::write, Writer(file), _1));
-        fclose(file);
+        PinnableSlice manifest;
+        s = db->Get(read_options, db->DefaultColumnFamily(), "m" + rocks_key(i), &manifest);
+        auto const nbr_of_chunks(manifest.size() / sizeof(Fingerprint));
+        vector<string> keys(nbr_of_chunks);
+        for (size_t c(0); c != nbr_of_chunks; ++c)
+        {
+            Fingerprint fp;
+            memcpy(&fp, manifest.data() + c * sizeof(fp), sizeof(fp));
+            keys[c] = dedup_chunk_key(fp);
+        }
+        vector<Slice> slices(keys.begin(), keys.end());
+        vector<PinnableSlice> values(nbr_of_chunks);
+        vector<Status> statuses(nbr_of_chunks);
+        db->MultiGet(read_options, db->DefaultColumnFamily(), nbr_of_chunks, slices.data(), values.data(), statuses.data());
+        size_t cursor(0);
+        for (size_t c(0); s.ok() && c != nbr_of_chunks; ++c)
+        {
+            s = statuses[c];
+            if (s.ok())
+            {
+                use_value(blob, values[c], cursor, true);
+                cursor += values[c].size();
+            }
+        }
+        if (!s.ok() || cursor != blob.size())
+        {
+            cout << "Failed to reconstruct blob " << i << " " << s.ToString() << endl;
+            delete db;
+            return 0.0;
+        }
+        verify_checksum(sums, i, blob);
         timer.stop();
         cout << '#';
     }
     cout << endl;
+
+    delete db;
+
     return timer.elapsedSeconds();
 }
 
-double seq_read_c_style_io(size_t blob_size, int count, string file_name)
+double write_dedup(Blob& blob, int count, string file_name)
 {
-    struct Reader
-    {
-        Reader(FILE* file) : m_file(file) {}
-        void read(Blob& blob) const { fread(blob.data(), 1, blob.size(), m_file); }
-        FILE* m_file;
-    };
+    return dedup_tuning.rocks ? write_dedup_rocks(blob, count, file_name) : write_dedup_pack(blob, count, file_name);
+}
 
-    using std::placeholders::_1;
+double read_dedup(Blob& blob, int count, string file_name)
+{
+    return dedup_tuning.rocks ? read_dedup_rocks(blob, count, file_name) : read_dedup_pack(blob, count, file_name);
+}
 
+double write_file_stream(Blob& blob, int count, string file_name)
+{
     Timer timer;
+    vector<uint32_t> sums;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        auto name = blob_name(file_name, i);
+        fill_blob(blob);
         timer.start();
-        FILE* file = fopen(name.c_str(), "rb");
-        read_chunks(blob_size, bind(&Reader::read, Reader(file), _1));
-        fclose(file);
+        if (!prepare_blob_file(name, blob.size()))
+            return 0.0;
+        auto myfile = ofstream(name, stream_write_mode());
+        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
+        myfile.write(blob.data(), blob.size());
+        myfile.close();
+        record_checksum(sums, blob);
         timer.stop();
         cout << '#';
     }
     cout << endl;
+    save_checksums(file_name, sums);
     return timer.elapsedSeconds();
 }
 
-double write_hdf5(Blob& blob, int count, string file_name)
+double read_file_stream(Blob& blob, int count, string file_name)
 {
-    using namespace H5;
-
-#pragma pack(push,1)
-    struct SLSSCommonHeader
-    {
-        char cFileSignature[6]{ 'A', 'B', 'C', 'C', 'D', 'E' };
-        int nVersion = 8;
-    } header;
-#pragma pack( pop )
-
-    hsize_t dims[1];
-    dims[0] = blob.size();
-    DataSpace dataspace(1, dims);
-
+    auto const sums(load_checksums(file_name));
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        fill_blob(blob);
-        auto name = file_name + to_string(i) + ".hdf5";
+        auto name = blob_name(file_name, i);
         timer.start();
-        FileCreatPropList fileProp;
-        fileProp.setUserblock(512);
-        H5File file(name, H5F_ACC_TRUNC, fileProp);
-        DataSet dataset = file.createDataSet("blob", PredType::STD_I8LE, dataspace);
-        dataset.write(blob.data(), PredType::NATIVE_CHAR);
-
-        file.close();
-
-        auto myfile = ofstream(name, ios::binary | ios::in | ios::out);
-        myfile.write((char*)&header, sizeof(header));
+        auto myfile = ifstream(name, ios::binary);
+        if (!myfile.read(blob.data(), blob.size()))
+        {
+            cout << "Short read of " << name << endl;
+            return 0.0;
+        }
         myfile.close();
-
+        verify_checksum(sums, i, blob);
         timer.stop();
         cout << '#';
     }
@@ -382,22 +1186,29 @@ double write_hdf5(Blob& blob, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double read_hdf5(Blob& blob, int count, string file_name)
+template<class Record = Fake>
+double seq_write_file_stream(size_t blob_size, int count, string file_name)
 {
-    using namespace H5;
+    struct Writer
+    {
+        Writer(ofstream& ofs) : m_ofs(ofs) {}
+        void write(Blob const& blob) const { m_ofs.write(blob.data(), blob.size()); }
+        ofstream& m_ofs;
+    };
 
-    hsize_t dims[1];
-    dims[0] = blob.size();
-    DataSpace dataspace(1, dims);
+    using std::placeholders::_1;
 
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i) + ".hdf5";
+        auto name = blob_name(file_name, i);
         timer.start();
-        H5File file(name, H5F_ACC_RDONLY);
-        DataSet dataset = file.openDataSet("blob");
-        dataset.read(blob.data(), PredType::NATIVE_CHAR);
+        if (!prepare_blob_file(name, blob_size))
+            return 0.0;
+        auto myfile = ofstream(name, stream_write_mode());
+        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
+        write_chunks<Record>(blob_size, timer, bind(&Writer::write, Writer(myfile), _1));
+        myfile.close();
         timer.stop();
         cout << '#';
     }
@@ -405,58 +1216,26 @@ double read_hdf5(Blob& blob, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double seq_write_hdf5(size_t blob_size, int count, string file_name)
+template<class Record = Fake>
+double seq_read_file_stream(size_t blob_size, int count, string file_name)
 {
-    using namespace H5;
-    using std::placeholders::_1;
-
-    struct Writer
+    struct Reader
     {
-        Writer(DataSet& dataset) : m_dataset(dataset) {}
-        void write(Blob const& blob)
-        {
-            if (m_cursor + blob.size() >= m_size[0])
-            {
-                m_size[0] += 1024*1024;
-                m_dataset.extend(m_size);
-            }
-            hsize_t dims[1]{ blob.size() };
-            DataSpace mspace(1, dims);
-            hsize_t offset[1]{ m_cursor };
-            DataSpace fspace(m_dataset.getSpace());
-            fspace.selectHyperslab(H5S_SELECT_SET, dims, offset);
-            //H5Dwrite_chunk(m_dataset.getId(), H5P_DEFAULT, 0, offset, blob.size(), blob.data());
-            m_dataset.write(blob.data(), PredType::NATIVE_CHAR, mspace, fspace);
-            m_cursor += blob.size();
-        }
-        DataSet& m_dataset;
-        hsize_t m_cursor{ 0 };
-        hsize_t m_size[1]{ 0 };
+        Reader(ifstream& ifs) : m_ifs(ifs) {}
+        void read(Blob& blob) const { m_ifs.read(blob.data(), blob.size()); }
+        ifstream& m_ifs;
     };
 
+    using std::placeholders::_1;
+
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i) + ".hdf5";
-        
+        auto name = blob_name(file_name, i);
         timer.start();
-
-        hsize_t fdims[1]{ 1024*1024*15 };
-        hsize_t fdims_max[1]{ H5S_UNLIMITED };
-        DataSpace fspace(1, fdims, fdims_max);
-
-        DSetCreatPropList cparms;
-        hsize_t chunk_dims[1]{ 1024*1024 };
-        cparms.setChunk(1, chunk_dims);
-
-        H5File file(name, H5F_ACC_TRUNC);
-        DataSet dataset = file.createDataSet("blobs", PredType::STD_I8LE, fspace, cparms);
-
-        Writer writer(dataset);
-        write_chunks(blob_size, timer, bind(&Writer::write, &writer, _1));
-
-        file.close();
-
+        auto myfile = ifstream(name, ios::binary);
+        read_chunks<Record>(blob_size, bind(&Reader::read, Reader(myfile), _1));
+        myfile.close();
         timer.stop();
         cout << '#';
     }
@@ -464,57 +1243,47 @@ double seq_write_hdf5(size_t blob_size, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double write_mio(Blob& blob, int count, string file_name)
+
+double write_c_style_io(Blob& blob, int count, string file_name)
 {
-    error_code error;
     Timer timer;
+    vector<uint32_t> sums;
     for (auto i(0); i != count; ++i)
     {
+        auto name = blob_name(file_name, i);
         fill_blob(blob);
-        auto name = file_name + to_string(i) + ".mio";
         timer.start();
-        auto myfile = ofstream(name, ios::binary | ios::trunc);
-        myfile.seekp(blob.size() - 1);
-        myfile.put('e');
-        myfile.close();
-        mio::mmap_sink rw_mmap = mio::make_mmap_sink(
-            name, 0, mio::map_entire_file, error);
-        if (error)
-        {
-            cout << error.message();
+        if (!prepare_blob_file(name, blob.size()))
             return 0.0;
-        }
-        copy(begin(blob), end(blob), begin(rw_mmap));
-        rw_mmap.sync(error);
-        if (error)
-        {
-            cout << error.message();
-            return 0.0;
-        }
-        rw_mmap.unmap();
+        FILE* file = fopen(name.c_str(), c_style_write_mode());
+        fwrite(blob.data(), 1, blob.size(), file);
+        fclose(file);
+        record_checksum(sums, blob);
         timer.stop();
         cout << '#';
     }
     cout << endl;
+    save_checksums(file_name, sums);
     return timer.elapsedSeconds();
 }
 
-double read_mio(Blob& blob, int count, string file_name)
+double read_c_style_io(Blob& blob, int count, string file_name)
 {
-    error_code error;
+    auto const sums(load_checksums(file_name));
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i) + ".mio";
+        auto name = blob_name(file_name, i);
         timer.start();
-        mio::mmap_source ro_mmap;
-        ro_mmap.map(name, error);
-        if (error)
+        FILE* file = fopen(name.c_str(), "rb");
+        auto const n = fread(blob.data(), 1, blob.size(), file);
+        fclose(file);
+        if (n != blob.size())
         {
-            cout << error.message();
+            cout << "Short read of " << name << endl;
             return 0.0;
         }
-        copy(begin(ro_mmap), end(ro_mmap), begin(blob));
+        verify_checksum(sums, i, blob);
         timer.stop();
         cout << '#';
     }
@@ -522,55 +1291,28 @@ double read_mio(Blob& blob, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double seq_write_mio(size_t blob_size, int count, string file_name)
+template<class Record = Fake>
+double seq_write_c_style_io(size_t blob_size, int count, string file_name)
 {
-    using namespace mio;
-    using std::placeholders::_1;
-
     struct Writer
     {
-        Writer(mmap_sink& rw_mmap) : m_rw_mmap(rw_mmap) {}
-        void write(Blob const& blob)
-        {
-            error_code error;
-            memcpy(&m_rw_mmap[m_cursor], blob.data(), blob.size());
-            if (error) 
-            {
-                spdlog::error("Fail to sync in mio");
-                return;
-            }
-            m_cursor += blob.size();
-        }
-        mmap_sink& m_rw_mmap;
-        size_t m_cursor{ 0 };
+        Writer(FILE* file) : m_file(file) {}
+        void write(Blob const& blob) const { fwrite(blob.data(), 1, blob.size(), m_file); }
+        FILE* m_file;
     };
 
-    error_code error;
+    using std::placeholders::_1;
+
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i) + ".mio";
+        auto name = blob_name(file_name, i);
         timer.start();
-        auto myfile = ofstream(name, ios::binary | ios::trunc);
-        myfile.seekp(blob_size - 1);
-        myfile.put('e');
-        myfile.close();
-        mio::mmap_sink rw_mmap = mio::make_mmap_sink(
-            name, 0, mio::map_entire_file, error);
-        if (error)
-        {
-            cout << error.message();
-            return 0.0;
-        }
-        Writer writer(rw_mmap);
-        write_chunks(blob_size, timer, bind(&Writer::write, &writer, _1));
-        rw_mmap.sync(error);
-        if (error)
-        {
-            cout << error.message();
+        if (!prepare_blob_file(name, blob_size))
             return 0.0;
-        }
-        rw_mmap.unmap();
+        FILE* file = fopen(name.c_str(), c_style_write_mode());
+        write_chunks<Record>(blob_size, timer, bind(&Writer::write, Writer(file), _1));
+        fclose(file);
         timer.stop();
         cout << '#';
     }
@@ -578,128 +1320,389 @@ double seq_write_mio(size_t blob_size, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double seq_read_mio(size_t blob_size, int count, string file_name)
+template<class Record = Fake>
+double seq_read_c_style_io(size_t blob_size, int count, string file_name)
 {
-    using namespace mio;
-
     struct Reader
     {
-        Reader(mmap_source& ro_mmap) : m_ro_mmap(ro_mmap) {}
-        void read(Blob& blob) const
-        {
-            memcpy(blob.data(), &m_ro_mmap[index], blob.size());
-            index += blob.size();
-        }
-        mmap_source& m_ro_mmap;
-        mutable size_t index{ 0 };
+        Reader(FILE* file) : m_file(file) {}
+        void read(Blob& blob) const { fread(blob.data(), 1, blob.size(), m_file); }
+        FILE* m_file;
     };
 
     using std::placeholders::_1;
 
-    error_code error;
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i) + ".mio";
+        auto name = blob_name(file_name, i);
         timer.start();
-        mmap_source ro_mmap;
-        ro_mmap.map(name, error);
-        if (error)
+        FILE* file = fopen(name.c_str(), "rb");
+        read_chunks<Record>(blob_size, bind(&Reader::read, Reader(file), _1));
+        fclose(file);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+// The records of the sequential tests gathered into iovecs, one per chunk,
+// and submitted with pwritev/preadv instead of stdio buffering. The buffer
+// holds a whole batch of records so random records can be filled up front.
+struct RecordBatch
+{
+    explicit RecordBatch(size_t records)
+        : data(records * record_size)
+    {
+        size_t offset(0);
+        for (size_t r(0); r != records; ++r)
         {
-            cout << error.message();
+            for (size_t c(0); c != record_chunks.size(); ++c)
+            {
+                fill(data.begin() + offset, data.begin() + offset + record_chunks[c], char('1' + c));
+                offset += record_chunks[c];
+            }
+        }
+    }
+
+    size_t records() const { return data.size() / record_size; }
+
+    Blob data;
+};
+
+#ifdef __linux__
+// iovecs for the first records of the batch
+void record_iovecs(RecordBatch& batch, size_t records, vector<iovec>& iov)
+{
+    iov.clear();
+    auto p(batch.data.data());
+    for (size_t r(0); r != records; ++r)
+    {
+        for (auto size : record_chunks)
+        {
+            iov.push_back(iovec{ p, size });
+            p += size;
+        }
+    }
+}
+#endif
+
+double seq_write_vectored(size_t blob_size, int count, string file_name)
+{
+#ifdef __linux__
+    auto const records(records_per_blob(blob_size));
+    RecordBatch batch(max<size_t>(1, min(vectored_tuning.batch, iov_max()) / record_chunks.size()));
+    vector<iovec> iov;
+
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+        if (!prepare_blob_file(name, blob_size))
+            return 0.0;
+        int fd = open(name.c_str(), O_WRONLY | O_CREAT | (alloc_policy == AllocPolicy::none ? O_TRUNC : 0), 0644);
+        if (fd < 0)
+        {
+            cout << strerror(errno);
             return 0.0;
         }
-        Reader reader(ro_mmap);
-        mmap_source::const_iterator iter(ro_mmap.begin());
-        read_chunks(blob_size, bind(&Reader::read, &reader, _1));
+        off_t offset(0);
+        for (size_t done(0); done < records;)
+        {
+            auto const n(min(batch.records(), records - done));
+            if (random_blobs)
+            {
+                timer.stop();
+                fill_blob(batch.data);
+                timer.start();
+            }
+            record_iovecs(batch, n, iov);
+            error_code error;
+            offset += transfer_vectored(fd, iov.data(), static_cast<int>(iov.size()), offset, vectored_tuning.flags, true, error);
+            if (error)
+            {
+                cout << error.message();
+                close(fd);
+                return 0.0;
+            }
+            done += n;
+        }
+        close(fd);
         timer.stop();
         cout << '#';
     }
     cout << endl;
     return timer.elapsedSeconds();
+#else
+    cout << "pwritev is only supported on Linux" << endl;
+    return 0.0;
+#endif
 }
 
-double seq_write_cereal(size_t blob_size, int count, string file_name)
+double seq_read_vectored(size_t blob_size, int count, string file_name)
 {
-    using namespace cereal;
-    using std::placeholders::_1;
+#ifdef __linux__
+    auto const records(records_per_blob(blob_size));
+    RecordBatch batch(max<size_t>(1, min(vectored_tuning.batch, iov_max()) / record_chunks.size()));
+    vector<iovec> iov;
 
-    struct Writer
+    Timer timer;
+    for (auto i(0); i != count; ++i)
     {
-        Writer(BinaryOutputArchive& oarchive, Fake& fake) : m_oarchive(oarchive), m_fake(fake) {}
-        void write(Blob const& blob) const { m_oarchive(m_fake); }
-        BinaryOutputArchive& m_oarchive;
-        Fake& m_fake;
-    };
+        auto name = blob_name(file_name, i);
+        timer.start();
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            cout << strerror(errno);
+            return 0.0;
+        }
+        off_t offset(0);
+        for (size_t done(0); done < records;)
+        {
+            auto const n(min(batch.records(), records - done));
+            record_iovecs(batch, n, iov);
+            error_code error;
+            auto const bytes(transfer_vectored(fd, iov.data(), static_cast<int>(iov.size()), offset, vectored_tuning.flags, false, error));
+            if (error || bytes != n * record_size)
+            {
+                cout << (error ? error.message() : "Short read of " + name) << endl;
+                close(fd);
+                return 0.0;
+            }
+            offset += bytes;
+            done += n;
+        }
+        close(fd);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+#else
+    cout << "preadv is only supported on Linux" << endl;
+    return 0.0;
+#endif
+}
 
-    Fake fake;
+#pragma pack(push,1)
+struct SLSSCommonHeader
+{
+    char cFileSignature[6]{ 'A', 'B', 'C', 'C', 'D', 'E' };
+    int nVersion = 8;
+};
+#pragma pack( pop )
+
+double write_hdf5(Blob& blob, int count, string file_name)
+{
+    using namespace H5;
+
+    SLSSCommonHeader header;
+
+    hsize_t dims[1];
+    dims[0] = blob.size();
+    DataSpace dataspace(1, dims);
 
     Timer timer;
+    vector<uint32_t> sums;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        fill_blob(blob);
+        auto name = blob_name(file_name, i, ".hdf5");
         timer.start();
-        auto myfile = ofstream(name, ios::binary | ios::trunc);
-        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
-        BinaryOutputArchive oarchive(myfile);
-        write_chunks(blob_size, timer, bind(&Writer::write, Writer(oarchive, fake), _1));
+        FileCreatPropList fileProp;
+        fileProp.setUserblock(512);
+        H5File file(name, H5F_ACC_TRUNC, fileProp);
+        DataSet dataset = file.createDataSet("blob", PredType::STD_I8LE, dataspace);
+        dataset.write(blob.data(), PredType::NATIVE_CHAR);
+
+        file.close();
+
+        auto myfile = ofstream(name, ios::binary | ios::in | ios::out);
+        myfile.write((char*)&header, sizeof(header));
         myfile.close();
+
+        record_checksum(sums, blob);
         timer.stop();
         cout << '#';
     }
     cout << endl;
+    save_checksums(file_name, sums);
     return timer.elapsedSeconds();
 }
 
-double seq_read_cereal(size_t blob_size, int count, string file_name)
+double read_hdf5(Blob& blob, int count, string file_name)
 {
-    using namespace cereal;
-    using std::placeholders::_1;
+    using namespace H5;
 
-    struct Reader
+    hsize_t dims[1];
+    dims[0] = blob.size();
+    DataSpace dataspace(1, dims);
+
+    auto const sums(load_checksums(file_name));
+    Timer timer;
+    for (auto i(0); i != count; ++i)
     {
-        Reader(BinaryInputArchive& iarchive, Fake& fake) : m_iarchive(iarchive), m_fake(fake) {}
-        void read(Blob& blob) const { m_iarchive(m_fake); }
-        BinaryInputArchive& m_iarchive;
-        Fake& m_fake;
-    };
+        auto name = blob_name(file_name, i, ".hdf5");
+        timer.start();
+        H5File file(name, H5F_ACC_RDONLY);
+        DataSet dataset = file.openDataSet("blob");
+        dataset.read(blob.data(), PredType::NATIVE_CHAR);
+        verify_checksum(sums, i, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
 
-    Fake fake;
+// All blobs as datasets of one HDF5 file that stays open, the header in the
+// userblock is written once when the file is closed
+double write_hdf5_store(Blob& blob, int count, string file_name)
+{
+    using namespace H5;
+
+    if (hdf5_tuning.driver == Hdf5Driver::direct && !hdf5_direct_supported())
+    {
+        cout << "HDF5 is built without the direct driver" << endl;
+        return 0.0;
+    }
+
+    SLSSCommonHeader header;
+    hsize_t dims[1]{ blob.size() };
+    DataSpace dataspace(1, dims);
+    auto const name(file_name + ".hdf5");
 
     Timer timer;
-    for (auto i(0); i != count; ++i)
+    vector<uint32_t> sums;
+    try
     {
-        auto name = file_name + to_string(i);
         timer.start();
-        auto myfile = ifstream(name, ios::binary);
-        BinaryInputArchive iarchive(myfile);
-        read_chunks(blob_size, bind(&Reader::read, Reader(iarchive, fake), _1));
+        H5File file(name, H5F_ACC_TRUNC, hdf5_create_props(hdf5_tuning, 512), hdf5_access_props(hdf5_tuning));
+        auto const create_props(hdf5_dataset_create_props(hdf5_tuning, blob.size()));
+        timer.stop();
+        for (auto i(0); i != count; ++i)
+        {
+            fill_blob(blob);
+            timer.start();
+            DataSet dataset = file.createDataSet("blob" + to_string(i), PredType::STD_I8LE, dataspace, create_props);
+            dataset.write(blob.data(), PredType::NATIVE_CHAR);
+            record_checksum(sums, blob);
+            timer.stop();
+            cout << '#';
+        }
+        timer.start();
+        file.close();
+
+        auto myfile = ofstream(name, ios::binary | ios::in | ios::out);
+        myfile.write((char*)&header, sizeof(header));
         myfile.close();
         timer.stop();
-        cout << '#';
+    }
+    catch (Exception const& e)
+    {
+        cout << e.getDetailMsg() << endl;
+        return 0.0;
     }
     cout << endl;
+    save_checksums(file_name, sums);
     return timer.elapsedSeconds();
 }
 
-double write_cereal(Blob& blob, int count, string file_name)
+double read_hdf5_store(Blob& blob, int count, string file_name)
 {
-    using namespace cereal;
+    using namespace H5;
 
-    auto nbrOfFakes(blob.size() / sizeof(Fake));
-    FakeData fakeData;
-    fakeData.fakes.resize(nbrOfFakes);
+    if (hdf5_tuning.driver == Hdf5Driver::direct && !hdf5_direct_supported())
+    {
+        cout << "HDF5 is built without the direct driver" << endl;
+        return 0.0;
+    }
+
+    auto const sums(load_checksums(file_name));
+    Timer timer;
+    try
+    {
+        timer.start();
+        H5File file(file_name + ".hdf5", H5F_ACC_RDONLY, FileCreatPropList::DEFAULT, hdf5_access_props(hdf5_tuning));
+        auto const access_props(hdf5_dataset_access_props(hdf5_tuning));
+        timer.stop();
+        for (auto i(0); i != count; ++i)
+        {
+            timer.start();
+            DataSet dataset = file.openDataSet("blob" + to_string(i), access_props);
+            dataset.read(blob.data(), PredType::NATIVE_CHAR);
+            verify_checksum(sums, i, blob);
+            timer.stop();
+            cout << '#';
+        }
+        timer.start();
+        file.close();
+        timer.stop();
+    }
+    catch (Exception const& e)
+    {
+        cout << e.getDetailMsg() << endl;
+        return 0.0;
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double seq_write_hdf5(size_t blob_size, int count, string file_name)
+{
+    using namespace H5;
+    using std::placeholders::_1;
+
+    struct Writer
+    {
+        Writer(DataSet& dataset) : m_dataset(dataset) {}
+        void write(Blob const& blob)
+        {
+            if (m_cursor + blob.size() >= m_size[0])
+            {
+                m_size[0] += 1024*1024;
+                m_dataset.extend(m_size);
+            }
+            hsize_t dims[1]{ blob.size() };
+            DataSpace mspace(1, dims);
+            hsize_t offset[1]{ m_cursor };
+            DataSpace fspace(m_dataset.getSpace());
+            fspace.selectHyperslab(H5S_SELECT_SET, dims, offset);
+            //H5Dwrite_chunk(m_dataset.getId(), H5P_DEFAULT, 0, offset, blob.size(), blob.data());
+            m_dataset.write(blob.data(), PredType::NATIVE_CHAR, mspace, fspace);
+            m_cursor += blob.size();
+        }
+        DataSet& m_dataset;
+        hsize_t m_cursor{ 0 };
+        hsize_t m_size[1]{ 0 };
+    };
 
     Timer timer;
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        auto name = blob_name(file_name, i, ".hdf5");
+        
         timer.start();
-        auto myfile = ofstream(name, ios::binary | ios::trunc);
-        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
-        BinaryOutputArchive oarchive(myfile);
-        oarchive(fakeData);
-        myfile.close();
+
+        hsize_t fdims[1]{ 1024*1024*15 };
+        hsize_t fdims_max[1]{ H5S_UNLIMITED };
+        DataSpace fspace(1, fdims, fdims_max);
+
+        DSetCreatPropList cparms;
+        hsize_t chunk_dims[1]{ 1024*1024 };
+        cparms.setChunk(1, chunk_dims);
+
+        H5File file(name, H5F_ACC_TRUNC);
+        DataSet dataset = file.createDataSet("blobs", PredType::STD_I8LE, fspace, cparms);
+
+        Writer writer(dataset);
+        write_chunks(blob_size, timer, bind(&Writer::write, &writer, _1));
+
+        file.close();
+
         timer.stop();
         cout << '#';
     }
@@ -707,112 +1710,2049 @@ double write_cereal(Blob& blob, int count, string file_name)
     return timer.elapsedSeconds();
 }
 
-double read_cereal(Blob& blob, int count, string file_name)
+// All blobs in one file that is mapped once, blob i at offset i * blob size
+double write_mio_persistent(Blob& blob, int count, string file_name)
 {
-    using namespace cereal;
-
-    FakeData fakeData;
+    error_code error;
+    auto name = file_name + "persistent.mio";
 
     Timer timer;
+    vector<uint32_t> sums;
+    timer.start();
+    if (!prepare_blob_file(name, blob.size() * count, true))
+        return 0.0;
+    mio::mmap_sink rw_mmap = mio::make_mmap_sink(
+        name, 0, mio::map_entire_file, error);
+    if (error)
+    {
+        cout << error.message();
+        return 0.0;
+    }
+    advise_mapping(rw_mmap.data(), rw_mmap.mapped_length(), mmap_tuning, true);
+    timer.stop();
+
     for (auto i(0); i != count; ++i)
     {
-        auto name = file_name + to_string(i);
+        fill_blob(blob);
+        size_t const offset(blob.size() * i);
         timer.start();
-        auto myfile = ifstream(name, ios::binary);
-        BinaryInputArchive iarchive(myfile);
-        iarchive(fakeData);
-        myfile.close();
+        copy(begin(blob), end(blob), begin(rw_mmap) + offset);
+        sync_range(rw_mmap.data(), offset, blob.size(), error);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        record_checksum(sums, blob);
         timer.stop();
         cout << '#';
     }
+    timer.start();
+    rw_mmap.unmap();
+    timer.stop();
     cout << endl;
+    save_checksums(file_name, sums);
     return timer.elapsedSeconds();
 }
 
-double write_tiledb(Blob& blob, int count, string file_name)
+double read_mio_persistent(Blob& blob, int count, string file_name)
+{
+    error_code error;
+    auto name = file_name + "persistent.mio";
+
+    auto const sums(load_checksums(file_name));
+    Timer timer;
+    timer.start();
+    mio::mmap_source ro_mmap;
+    ro_mmap.map(name, error);
+    if (error)
+    {
+        cout << error.message();
+        return 0.0;
+    }
+    advise_mapping(ro_mmap.data(), ro_mmap.mapped_length(), mmap_tuning, false);
+    timer.stop();
+
+    for (auto i(0); i != count; ++i)
+    {
+        size_t const offset(blob.size() * i);
+        timer.start();
+        copy(begin(ro_mmap) + offset, begin(ro_mmap) + offset + blob.size(), begin(blob));
+        verify_checksum(sums, i, blob);
+        timer.stop();
+        cout << '#';
+    }
+    timer.start();
+    ro_mmap.unmap();
+    timer.stop();
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double write_mio(Blob& blob, int count, string file_name)
+{
+    if (mmap_tuning.persistent)
+        return write_mio_persistent(blob, count, file_name);
+
+    error_code error;
+    Timer timer;
+    vector<uint32_t> sums;
+    for (auto i(0); i != count; ++i)
+    {
+        fill_blob(blob);
+        auto name = blob_name(file_name, i, ".mio");
+        timer.start();
+        if (!prepare_blob_file(name, blob.size(), true))
+            return 0.0;
+        mio::mmap_sink rw_mmap = mio::make_mmap_sink(
+            name, 0, mio::map_entire_file, error);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        advise_mapping(rw_mmap.data(), rw_mmap.mapped_length(), mmap_tuning, true);
+        copy(begin(blob), end(blob), begin(rw_mmap));
+        rw_mmap.sync(error);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        rw_mmap.unmap();
+        record_checksum(sums, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    save_checksums(file_name, sums);
+    return timer.elapsedSeconds();
+}
+
+double read_mio(Blob& blob, int count, string file_name)
+{
+    if (mmap_tuning.persistent)
+        return read_mio_persistent(blob, count, file_name);
+
+    error_code error;
+    auto const sums(load_checksums(file_name));
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i, ".mio");
+        timer.start();
+        mio::mmap_source ro_mmap;
+        ro_mmap.map(name, error);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        advise_mapping(ro_mmap.data(), ro_mmap.mapped_length(), mmap_tuning, false);
+        copy(begin(ro_mmap), end(ro_mmap), begin(blob));
+        verify_checksum(sums, i, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+template<class Record = Fake>
+double seq_write_mio(size_t blob_size, int count, string file_name)
+{
+    using namespace mio;
+    using std::placeholders::_1;
+
+    struct Writer
+    {
+        Writer(mmap_sink& rw_mmap) : m_rw_mmap(rw_mmap) {}
+        void write(Blob const& blob)
+        {
+            error_code error;
+            memcpy(&m_rw_mmap[m_cursor], blob.data(), blob.size());
+            if (error) 
+            {
+                spdlog::error("Fail to sync in mio");
+                return;
+            }
+            m_cursor += blob.size();
+        }
+        mmap_sink& m_rw_mmap;
+        size_t m_cursor{ 0 };
+    };
+
+    error_code error;
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i, ".mio");
+        timer.start();
+        if (!prepare_blob_file(name, blob_size, true))
+            return 0.0;
+        mio::mmap_sink rw_mmap = mio::make_mmap_sink(
+            name, 0, mio::map_entire_file, error);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        advise_mapping(rw_mmap.data(), rw_mmap.mapped_length(), mmap_tuning, true);
+        Writer writer(rw_mmap);
+        write_chunks<Record>(blob_size, timer, bind(&Writer::write, &writer, _1));
+        rw_mmap.sync(error);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        rw_mmap.unmap();
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+template<class Record = Fake>
+double seq_read_mio(size_t blob_size, int count, string file_name)
+{
+    using namespace mio;
+
+    struct Reader
+    {
+        Reader(mmap_source& ro_mmap) : m_ro_mmap(ro_mmap) {}
+        void read(Blob& blob) const
+        {
+            memcpy(blob.data(), &m_ro_mmap[index], blob.size());
+            index += blob.size();
+        }
+        mmap_source& m_ro_mmap;
+        mutable size_t index{ 0 };
+    };
+
+    using std::placeholders::_1;
+
+    error_code error;
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i, ".mio");
+        timer.start();
+        mmap_source ro_mmap;
+        ro_mmap.map(name, error);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        advise_mapping(ro_mmap.data(), ro_mmap.mapped_length(), mmap_tuning, false);
+        Reader reader(ro_mmap);
+        mmap_source::const_iterator iter(ro_mmap.begin());
+        read_chunks<Record>(blob_size, bind(&Reader::read, &reader, _1));
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double seq_write_cereal(size_t blob_size, int count, string file_name)
+{
+    using namespace cereal;
+    using std::placeholders::_1;
+
+    struct Writer
+    {
+        Writer(BinaryOutputArchive& oarchive, Fake& fake) : m_oarchive(oarchive), m_fake(fake) {}
+        void write(Blob const& blob) const { m_oarchive(m_fake); }
+        BinaryOutputArchive& m_oarchive;
+        Fake& m_fake;
+    };
+
+    Fake fake;
+
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+        auto myfile = ofstream(name, ios::binary | ios::trunc);
+        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
+        BinaryOutputArchive oarchive(myfile);
+        write_chunks(blob_size, timer, bind(&Writer::write, Writer(oarchive, fake), _1));
+        myfile.close();
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double seq_read_cereal(size_t blob_size, int count, string file_name)
+{
+    using namespace cereal;
+    using std::placeholders::_1;
+
+    struct Reader
+    {
+        Reader(BinaryInputArchive& iarchive, Fake& fake) : m_iarchive(iarchive), m_fake(fake) {}
+        void read(Blob& blob) const { m_iarchive(m_fake); }
+        BinaryInputArchive& m_iarchive;
+        Fake& m_fake;
+    };
+
+    Fake fake;
+
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+        auto myfile = ifstream(name, ios::binary);
+        BinaryInputArchive iarchive(myfile);
+        read_chunks(blob_size, bind(&Reader::read, Reader(iarchive, fake), _1));
+        myfile.close();
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double write_cereal(Blob& blob, int count, string file_name)
+{
+    using namespace cereal;
+
+    auto nbrOfFakes(blob.size() / sizeof(Fake));
+    FakeData fakeData;
+    fakeData.fakes.resize(nbrOfFakes);
+
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+        auto myfile = ofstream(name, ios::binary | ios::trunc);
+        myfile.rdbuf()->pubsetbuf(buf.get(), bufsize);
+        BinaryOutputArchive oarchive(myfile);
+        oarchive(fakeData);
+        myfile.close();
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double read_cereal(Blob& blob, int count, string file_name)
+{
+    using namespace cereal;
+
+    FakeData fakeData;
+
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+        auto myfile = ifstream(name, ios::binary);
+        BinaryInputArchive iarchive(myfile);
+        iarchive(fakeData);
+        myfile.close();
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double write_tiledb(Blob& blob, int count, string file_name)
+{
+    using namespace tiledb;
+
+    Timer timer;
+    vector<uint32_t> sums;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+
+        Context ctx(tiledb_config());
+
+        ArraySchema schema(ctx, TILEDB_DENSE);
+
+        Domain domain(ctx);
+        domain.add_dimension(Dimension::create<int8_t>(ctx, "blob", { { 1, 1 } }, 1));
+
+        schema.set_domain(domain).set_order({ { TILEDB_ROW_MAJOR, TILEDB_ROW_MAJOR } });
+
+        schema.add_attribute(Attribute::create<vector<char>>(ctx, "data"));
+
+        Array::create(name, schema);
+
+        Array array(ctx, name, TILEDB_WRITE);
+        
+        vector<uint64_t> off(1, 0);
+
+        Query query(ctx, array);
+        query.set_layout(TILEDB_ROW_MAJOR)
+            .set_buffer("data", off, blob);
+        query.submit();
+        array.close();
+
+        record_checksum(sums, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    save_checksums(file_name, sums);
+    return timer.elapsedSeconds();
+}
+
+double read_tiledb(Blob& blob, int count, string file_name)
 {
     using namespace tiledb;
 
-    Timer timer;
-    for (auto i(0); i != count; ++i)
+    auto const sums(load_checksums(file_name));
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+
+        Context ctx(tiledb_config());
+
+        Array array(ctx, name, TILEDB_READ);
+
+        vector<int8_t> const subarray = { 1, 1 };
+
+        auto max_el_map = array.max_buffer_elements(subarray);
+        std::vector<uint64_t> off(max_el_map["data"].first);
+
+        Query query(ctx, array);
+        query.set_subarray(subarray)
+            .set_layout(TILEDB_ROW_MAJOR)
+            .set_buffer("data", off, blob);
+        query.submit();
+        array.close();
+
+        verify_checksum(sums, i, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+}
+
+double write_direct_io(Blob& blob, int count, string file_name)
+{
+#ifdef __linux__
+    // O_DIRECT needs aligned buffers and lengths, the tail is cut off with ftruncate
+    auto const size(align_up(blob.size()));
+    auto aligned(make_aligned_buffer(size));
+    memset(aligned.get() + blob.size(), 0, size - blob.size());
+
+    Timer timer;
+    vector<uint32_t> sums;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        fill_blob(blob);
+        copy(begin(blob), end(blob), aligned.get());
+        timer.start();
+        int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if (fd < 0)
+        {
+            cout << strerror(errno);
+            return 0.0;
+        }
+        error_code error;
+        preallocate(fd, size, alloc_policy, false, error);
+        size_t done(0);
+        while (!error && done != size)
+        {
+            auto n = pwrite(fd, aligned.get() + done, size - done, done);
+            if (n <= 0)
+                error.assign(errno, generic_category());
+            else
+                done += n;
+        }
+        if (!error && size != blob.size() && ftruncate(fd, blob.size()) != 0)
+            error.assign(errno, generic_category());
+        close(fd);
+        if (error)
+        {
+            cout << error.message();
+            return 0.0;
+        }
+        record_checksum(sums, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    save_checksums(file_name, sums);
+    return timer.elapsedSeconds();
+#else
+    cout << "O_DIRECT is only supported on Linux" << endl;
+    return 0.0;
+#endif
+}
+
+double read_direct_io(Blob& blob, int count, string file_name)
+{
+#ifdef __linux__
+    auto const size(align_up(blob.size()));
+    auto aligned(make_aligned_buffer(size));
+
+    auto const sums(load_checksums(file_name));
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+        int fd = open(name.c_str(), O_RDONLY | O_DIRECT);
+        if (fd < 0)
+        {
+            cout << strerror(errno);
+            return 0.0;
+        }
+        size_t done(0);
+        while (done < blob.size())
+        {
+            auto n = pread(fd, aligned.get() + done, size - done, done);
+            if (n <= 0)
+                break;
+            done += n;
+        }
+        close(fd);
+        if (done < blob.size())
+        {
+            cout << "Short read of " << name << endl;
+            return 0.0;
+        }
+        copy(aligned.get(), aligned.get() + blob.size(), begin(blob));
+        verify_checksum(sums, i, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+#else
+    cout << "O_DIRECT is only supported on Linux" << endl;
+    return 0.0;
+#endif
+}
+
+double read_pread(Blob& blob, int count, string file_name)
+{
+#ifdef __linux__
+    auto const sums(load_checksums(file_name));
+    Timer timer;
+    for (auto i(0); i != count; ++i)
+    {
+        auto name = blob_name(file_name, i);
+        timer.start();
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            cout << strerror(errno);
+            return 0.0;
+        }
+        size_t done(0);
+        while (done < blob.size())
+        {
+            auto n = pread(fd, blob.data() + done, blob.size() - done, done);
+            if (n <= 0)
+                break;
+            done += n;
+        }
+        close(fd);
+        if (done < blob.size())
+        {
+            cout << "Short read of " << name << endl;
+            return 0.0;
+        }
+        verify_checksum(sums, i, blob);
+        timer.stop();
+        cout << '#';
+    }
+    cout << endl;
+    return timer.elapsedSeconds();
+#else
+    cout << "pread is only supported on Linux" << endl;
+    return 0.0;
+#endif
+}
+
+enum class MetaOp { create, open, stat, unlink };
+
+// One metadata operation on an empty file, returns false on failure
+bool meta_op(MetaOp op, string const& name)
+{
+#ifdef __linux__
+    struct stat st;
+    int fd(-1);
+    switch (op)
+    {
+    case MetaOp::create:
+        fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        return fd >= 0 && ::close(fd) == 0;
+    case MetaOp::open:
+        fd = ::open(name.c_str(), O_RDONLY);
+        return fd >= 0 && ::close(fd) == 0;
+    case MetaOp::stat:
+        return ::stat(name.c_str(), &st) == 0;
+    case MetaOp::unlink:
+        return ::unlink(name.c_str()) == 0;
+    }
+    return false;
+#else
+    error_code error;
+    FILE* file(nullptr);
+    switch (op)
+    {
+    case MetaOp::create:
+        file = fopen(name.c_str(), "wb");
+        return file != nullptr && fclose(file) == 0;
+    case MetaOp::open:
+        file = fopen(name.c_str(), "rb");
+        return file != nullptr && fclose(file) == 0;
+    case MetaOp::stat:
+        filesystem::status(name, error);
+        return !error;
+    case MetaOp::unlink:
+        return remove(name.c_str()) == 0;
+    }
+    return false;
+#endif
+}
+
+// Metadata rate of count files spread over nbr_of_threads threads
+double meta_files(MetaOp op, int count, string file_name)
+{
+    atomic<int> failures{ 0 };
+
+    Timer timer;
+    timer.start();
+    run_threads(count, [&](int begin, int end)
+    {
+        for (auto i(begin); i != end; ++i)
+        {
+            if (!meta_op(op, blob_name(file_name, i)))
+                ++failures;
+        }
+    });
+    timer.stop();
+
+    if (failures != 0)
+    {
+        cout << failures << " of " << count << " operations failed" << endl;
+    }
+    return timer.elapsedSeconds();
+}
+
+// Reads blob i of the data of a write test, for tests that read the blobs of
+// any backend. Must be safe to call from several threads.
+using BlobReader = function<bool(int, Blob&)>;
+
+struct BlobSource
+{
+    BlobReader read;
+    string file_name;             // Data and checksums of the write test
+    function<string(int)> path{}; // File of blob i, empty when blobs aren't files
+};
+
+// Where the write test of a backend keeps its blobs
+string backend_file_name(string const& backend, string const& path, string const& extension)
+{
+    if (backend == "file")
+        return path + "/write_file_stream" + extension;
+    if (backend == "c_style")
+        return path + "/write_c_style_io" + extension;
+    if (backend == "mio")
+        return path + "/write_mio" + extension;
+    if (backend == "cereal")
+        return path + "/write_cereal" + extension;
+    if (backend == "hdf5")
+        return path + "/write_hdf5" + extension;
+    if (backend == "rocks")
+        return path + "/rocksdb";
+    return string();
+}
+
+BlobSource blob_source(string const& backend, string const& path, string const& extension)
+{
+    auto const file_name(backend_file_name(backend, path, extension));
+    if (backend == "file")
+    {
+        return { [file_name](int i, Blob& blob)
+        {
+            auto myfile = ifstream(blob_name(file_name, i), ios::binary);
+            return bool(myfile.read(blob.data(), blob.size()));
+        }, file_name, [file_name](int i) { return blob_name(file_name, i); } };
+    }
+    if (backend == "c_style")
+    {
+        return { [file_name](int i, Blob& blob)
+        {
+            FILE* file = fopen(blob_name(file_name, i).c_str(), "rb");
+            if (file == nullptr)
+                return false;
+            auto const done(fread(blob.data(), 1, blob.size(), file));
+            fclose(file);
+            return done == blob.size();
+        }, file_name, [file_name](int i) { return blob_name(file_name, i); } };
+    }
+    if (backend == "mio")
+    {
+        return { [file_name](int i, Blob& blob)
+        {
+            error_code error;
+            mio::mmap_source ro_mmap;
+            ro_mmap.map(blob_name(file_name, i, ".mio"), error);
+            if (error || ro_mmap.size() < blob.size())
+                return false;
+            copy(ro_mmap.begin(), ro_mmap.begin() + blob.size(), blob.begin());
+            return true;
+        }, file_name, [file_name](int i) { return blob_name(file_name, i, ".mio"); } };
+    }
+    if (backend == "cereal")
+    {
+        return { [file_name](int i, Blob& blob)
+        {
+            FakeData fakeData;
+            auto myfile = ifstream(blob_name(file_name, i), ios::binary);
+            if (!myfile)
+                return false;
+            cereal::BinaryInputArchive iarchive(myfile);
+            iarchive(fakeData);
+            memcpy(blob.data(), fakeData.fakes.data(), min(blob.size(), fakeData.fakes.size() * sizeof(Fake)));
+            return true;
+        }, file_name, [file_name](int i) { return blob_name(file_name, i); } };
+    }
+    if (backend == "hdf5")
+    {
+        return { [file_name](int i, Blob& blob)
+        {
+            // The HDF5 library is not thread safe
+            static mutex hdf5_mutex;
+            lock_guard<mutex> lock(hdf5_mutex);
+            try
+            {
+                H5::H5File file(blob_name(file_name, i, ".hdf5"), H5F_ACC_RDONLY);
+                file.openDataSet("blob").read(blob.data(), H5::PredType::NATIVE_CHAR);
+                return true;
+            }
+            catch (H5::Exception const& e)
+            {
+                cout << e.getDetailMsg() << endl;
+                return false;
+            }
+        }, file_name, [file_name](int i) { return blob_name(file_name, i, ".hdf5"); } };
+    }
+    if (backend == "rocks")
+    {
+        DB* db;
+        Status s = DB::Open(rocks_options(), file_name, &db);
+        if (!s.ok())
+        {
+            cout << s.ToString();
+            return { BlobReader(), file_name };
+        }
+        shared_ptr<DB> shared_db(db);
+        return { [shared_db](int i, Blob& blob)
+        {
+            PinnableSlice value;
+            if (!shared_db->Get(rocks_read_options(), shared_db->DefaultColumnFamily(), rocks_key(i), &value).ok())
+                return false;
+            use_value(blob, value, 0, true);
+            return true;
+        }, file_name };
+    }
+    cout << "Unknown cache backend " << backend << endl;
+    return { BlobReader(), string() };
+}
+
+// Zipf distributed requests for the blobs of a backend through a BlobCache,
+// the blobs missing in the cache are read from the backend and put in it
+double read_cached(Blob& blob, int count, BlobSource const& source)
+{
+    last_cached_requests = 0;
+    if (!source.read)
+        return 0.0;
+
+    auto const requests(cache_tuning.reads != 0 ? cache_tuning.reads : count * 10);
+    auto shards(cache_tuning.shards);
+    if (shards == 0)
+        shards = int(max<size_t>(1, min<size_t>(16, cache_tuning.capacity / (4 * max<size_t>(1, blob.size())))));
+    BlobCache cache(cache_tuning.capacity, shards, cache_tuning.admission, cache_tuning.compress);
+    ZipfGenerator const zipf(count, cache_tuning.skew);
+    auto const sums(load_checksums(source.file_name));
+    mutex verify_mutex;
+    atomic<int> failures{ 0 };
+
+    Timer timer;
+    timer.start();
+    run_threads(requests, [&](int begin, int end)
+    {
+        random_device rnd;
+        default_random_engine eng(rnd());
+        Blob buffer(blob.size());
+        for (auto r(begin); r != end; ++r)
+        {
+            auto const i(static_cast<int>(zipf(eng)));
+            if (!cache.get(i, buffer))
+            {
+                if (!source.read(i, buffer))
+                {
+                    ++failures;
+                    continue;
+                }
+                cache.put(i, buffer);
+            }
+            if (verify_blobs)
+            {
+                lock_guard<mutex> lock(verify_mutex);
+                verify_checksum(sums, i, buffer);
+            }
+        }
+    });
+    timer.stop();
+
+    if (failures != 0)
+    {
+        cout << failures << " of " << requests << " reads failed" << endl;
+        return 0.0;
+    }
+
+    auto const stats(cache.stats());
+    spdlog::info("{:5.1f}% hits, {} of {} blobs cached in {:7.1f}MB ({:7.1f}MB of blobs), {} evictions, {} rejected, {} requests :read_cached_{}",
+        stats.hit_rate() * 100.0, stats.entries, count, stats.bytes / 1048576.0, stats.blob_bytes / 1048576.0,
+        stats.evictions, stats.rejected, requests, cache_tuning.backend);
+    last_cached_requests = requests;
+    return timer.elapsedSeconds();
+}
+
+// Prefetching in threads mode, blobs are read into a pool of depth buffers
+double read_prefetched_threads(Blob& blob, int count, BlobSource const& source, vector<uint32_t> const& sums, double& wait_secs)
+{
+    Timer timer;
+    timer.start();
+    Prefetcher prefetcher(source.read, count, blob.size(), prefetch_tuning.depth, prefetch_tuning.threads);
+    for (auto i(0); i != count; ++i)
+    {
+        auto data = prefetcher.acquire(i);
+        if (data == nullptr)
+        {
+            cout << "Failed to read blob " << i << endl;
+            return 0.0;
+        }
+        memcpy(blob.data(), data->data(), min(blob.size(), data->size()));
+        prefetcher.release(i);
+        verify_checksum(sums, i, blob);
+        cout << '#';
+    }
+    timer.stop();
+    wait_secs = prefetcher.wait_seconds();
+    return timer.elapsedSeconds();
+}
+
+// Prefetching in fadvise mode, the next depth blobs are opened and the
+// kernel is asked to read them with posix_fadvise(WILLNEED)
+double read_prefetched_fadvise(Blob& blob, int count, BlobSource const& source, vector<uint32_t> const& sums, double& read_secs)
+{
+#ifdef __linux__
+    if (!source.path)
+    {
+        cout << "fadvise prefetching needs a backend with a file per blob" << endl;
+        return 0.0;
+    }
+
+    vector<int> fds(prefetch_tuning.depth + 1, -1);
+    auto const advise = [&](int i)
+    {
+        auto& fd(fds[i % fds.size()]);
+        fd = open(source.path(i).c_str(), O_RDONLY);
+        if (fd >= 0)
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    };
+
+    Timer timer;
+    Timer reads;
+    auto failed(false);
+    timer.start();
+    for (auto i(0); i != min(count, prefetch_tuning.depth); ++i)
+        advise(i);
+    for (auto i(0); i != count; ++i)
+    {
+        if (i + prefetch_tuning.depth < count)
+            advise(i + prefetch_tuning.depth);
+        reads.start();
+        auto const ok(source.read(i, blob));
+        reads.stop();
+        auto& fd(fds[i % fds.size()]);
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        if (!ok)
+        {
+            cout << "Failed to read blob " << i << endl;
+            failed = true;
+            break;
+        }
+        verify_checksum(sums, i, blob);
+        cout << '#';
+    }
+    for (auto fd : fds)
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+    timer.stop();
+    read_secs = reads.elapsedSeconds();
+    return failed ? 0.0 : timer.elapsedSeconds();
+#else
+    cout << "posix_fadvise is only supported on Linux" << endl;
+    return 0.0;
+#endif
+}
+
+// Sequential reads of all blobs of a backend with a prefetch stage in front.
+// In threads mode the wait is the time the reader is blocked on a blob that
+// isn't there yet. The other modes read synchronously and can't tell the
+// wait for the device apart from the copy, they report the read time.
+double read_prefetched(Blob& blob, int count, BlobSource const& source)
+{
+    if (!source.read)
+        return 0.0;
+
+    auto const sums(load_checksums(source.file_name));
+    double secs(0.0);
+    double wait_secs(0.0);
+    if (prefetch_tuning.mode == PrefetchMode::threads)
+    {
+        secs = read_prefetched_threads(blob, count, source, sums, wait_secs);
+    }
+    else if (prefetch_tuning.mode == PrefetchMode::fadvise)
+    {
+        secs = read_prefetched_fadvise(blob, count, source, sums, wait_secs);
+    }
+    else
+    {
+        Timer timer;
+        for (auto i(0); i != count; ++i)
+        {
+            timer.start();
+            auto const ok(source.read(i, blob));
+            timer.stop();
+            if (!ok)
+            {
+                cout << "Failed to read blob " << i << endl;
+                return 0.0;
+            }
+            verify_checksum(sums, i, blob);
+            cout << '#';
+        }
+        secs = wait_secs = timer.elapsedSeconds();
+    }
+    cout << endl;
+
+    if (secs != 0.0 && count != 0)
+    {
+        spdlog::info("{:9.3f}ms {} per blob, {:5.1f}% of the time, depth {} :read_prefetched_{}",
+            wait_secs * 1000.0 / count, prefetch_tuning.mode == PrefetchMode::threads ? "wait" : "read",
+            wait_secs * 100.0 / secs, prefetch_tuning.depth, prefetch_tuning.backend);
+    }
+    return secs;
+}
+
+// Reads all blobs of a backend on a thread pinned to cpu_node into a buffer
+// bound to mem_node, to compare local and remote memory
+double read_numa(Blob& blob, int count, BlobSource const& source, int cpu_node, int mem_node)
+{
+    if (!source.read)
+        return 0.0;
+
+    auto const sums(load_checksums(source.file_name));
+    double secs(0.0);
+    thread reader([&]
+    {
+        if (!pin_thread_to_node(cpu_node))
+        {
+            cout << "Failed to pin to node " << cpu_node << endl;
+            return;
+        }
+        Blob local(blob.size());
+        if (!bind_to_node(local.data(), local.size(), mem_node) && numa_nodes() > 1)
+            cout << "Failed to bind memory to node " << mem_node << endl;
+
+        Timer timer;
+        for (auto i(0); i != count; ++i)
+        {
+            timer.start();
+            auto const ok(source.read(i, local));
+            timer.stop();
+            if (!ok)
+            {
+                cout << "Failed to read blob " << i << endl;
+                return;
+            }
+            verify_checksum(sums, i, local);
+            cout << '#';
+        }
+        cout << endl;
+        spdlog::info("cpu node {}, memory on node {} :read_numa", current_node(), memory_node(local.data() + local.size() / 2));
+        secs = timer.elapsedSeconds();
+    });
+    reader.join();
+    return secs;
+}
+
+// Writes blob i to a backend, the write side of BlobSource
+using BlobWriter = function<bool(int, Blob const&)>;
+
+struct BlobSink
+{
+    BlobWriter write;
+    string file_name;
+};
+
+BlobSink blob_sink(string const& backend, string const& file_name)
+{
+    if (backend == "file")
+    {
+        return { [file_name](int i, Blob const& blob)
+        {
+            auto name = blob_name(file_name, i);
+            if (!prepare_blob_file(name, blob.size()))
+                return false;
+            auto myfile = ofstream(name, stream_write_mode());
+            return bool(myfile.write(blob.data(), blob.size()));
+        }, file_name };
+    }
+    if (backend == "c_style")
+    {
+        return { [file_name](int i, Blob const& blob)
+        {
+            auto name = blob_name(file_name, i);
+            if (!prepare_blob_file(name, blob.size()))
+                return false;
+            FILE* file = fopen(name.c_str(), c_style_write_mode());
+            if (file == nullptr)
+                return false;
+            auto const done(fwrite(blob.data(), 1, blob.size(), file));
+            return fclose(file) == 0 && done == blob.size();
+        }, file_name };
+    }
+    if (backend == "mio")
+    {
+        return { [file_name](int i, Blob const& blob)
+        {
+            auto name = blob_name(file_name, i, ".mio");
+            if (!prepare_blob_file(name, blob.size(), true))
+                return false;
+            error_code error;
+            mio::mmap_sink rw_mmap = mio::make_mmap_sink(name, 0, mio::map_entire_file, error);
+            if (error)
+                return false;
+            copy(blob.begin(), blob.end(), rw_mmap.begin());
+            rw_mmap.sync(error);
+            return !error;
+        }, file_name };
+    }
+    if (backend == "hdf5")
+    {
+        return { [file_name](int i, Blob const& blob)
+        {
+            try
+            {
+                hsize_t dims[1]{ blob.size() };
+                H5::DataSpace dataspace(1, dims);
+                H5::H5File file(blob_name(file_name, i, ".hdf5"), H5F_ACC_TRUNC);
+                file.createDataSet("blob", H5::PredType::STD_I8LE, dataspace).write(blob.data(), H5::PredType::NATIVE_CHAR);
+                return true;
+            }
+            catch (H5::Exception const& e)
+            {
+                cout << e.getDetailMsg() << endl;
+                return false;
+            }
+        }, file_name };
+    }
+    if (backend == "rocks")
+    {
+        DB* db;
+        Options options(rocks_options());
+        options.create_if_missing = true;
+        Status s = DB::Open(options, file_name, &db);
+        if (!s.ok())
+        {
+            cout << s.ToString();
+            return { BlobWriter(), file_name };
+        }
+        shared_ptr<DB> shared_db(db);
+        return { [shared_db](int i, Blob const& blob)
+        {
+            return shared_db->Put(WriteOptions(), rocks_key(i), Slice(blob.data(), blob.size())).ok();
+        }, file_name };
+    }
+    cout << "Unknown backend " << backend << endl;
+    return { BlobWriter(), file_name };
+}
+
+int64_t steady_ns()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A producer thread streams the blobs over a loopback socket and the
+// receiver writes them. splice moves the data from the socket to the
+// files without copying it to user space, recv receives into one page
+// aligned buffer that is reused for all blobs and writes it out, and any
+// other mode receives into the blob and writes it with that backend.
+// The time and latency are end to end, from the first byte sent to the
+// last byte written. Nothing is synced, written means handed to the page
+// cache (or to RocksDB and HDF5) rather than on disk.
+double ingest(Blob& blob, int count, string file_name)
+{
+#ifdef __linux__
+    auto const splicing(ingest_tuning.mode == "splice");
+    auto const receiving(ingest_tuning.mode == "recv");
+    BlobSink sink;
+    if (!splicing && !receiving)
+    {
+        sink = blob_sink(ingest_tuning.mode, file_name);
+        if (!sink.write)
+            return 0.0;
+    }
+
+    int producer, consumer;
+    error_code error;
+    if (!connect_loopback(ingest_tuning.transport, producer, consumer, error))
+    {
+        cout << error.message();
+        return 0.0;
+    }
+    int pipe_fds[2]{ -1, -1 };
+    if (splicing)
+    {
+        if (pipe(pipe_fds) != 0)
+        {
+            cout << strerror(errno);
+            close(producer);
+            close(consumer);
+            return 0.0;
+        }
+        fcntl(pipe_fds[1], F_SETPIPE_SZ, 1024 * 1024);
+    }
+    auto buffer(receiving ? make_aligned_buffer(blob.size()) : AlignedBuffer());
+    Blob received(receiving || splicing ? 0 : blob.size());
+    fill_blob(blob);
+
+    vector<double> latencies;
+    auto failed(false);
+
+    Timer timer;
+    timer.start();
+    thread sender([&]
+    {
+        for (auto i(0); i != count; ++i)
+        {
+            IngestHeader header{ blob.size(), steady_ns() };
+            if (!send_all(producer, reinterpret_cast<char const*>(&header), sizeof(header))
+                || !send_all(producer, blob.data(), blob.size()))
+                break;
+        }
+        shutdown(producer, SHUT_WR);
+    });
+
+    for (auto i(0); i != count && !failed; ++i)
+    {
+        IngestHeader header;
+        if (!recv_all(consumer, reinterpret_cast<char*>(&header), sizeof(header)) || header.size != blob.size())
+        {
+            cout << "Lost the producer at blob " << i << endl;
+            failed = true;
+            break;
+        }
+
+        if (splicing || receiving)
+        {
+            auto name = blob_name(file_name, i);
+            if (!prepare_blob_file(name, blob.size()))
+            {
+                failed = true;
+                break;
+            }
+            int fd = open(name.c_str(), O_WRONLY | O_CREAT | (alloc_policy == AllocPolicy::none ? O_TRUNC : 0), 0644);
+            if (fd < 0)
+            {
+                cout << strerror(errno);
+                failed = true;
+                break;
+            }
+            if (splicing)
+            {
+                failed = !splice_to_file(consumer, pipe_fds, fd, blob.size(), error);
+            }
+            else if (!recv_all(consumer, buffer.get(), blob.size()))
+            {
+                error = make_error_code(errc::connection_reset);
+                failed = true;
+            }
+            else
+            {
+                size_t done(0);
+                while (!failed && done < blob.size())
+                {
+                    auto n = pwrite(fd, buffer.get() + done, blob.size() - done, done);
+                    if (n <= 0)
+                    {
+                        error.assign(errno, generic_category());
+                        failed = true;
+                    }
+                    else
+                        done += n;
+                }
+            }
+            close(fd);
+            if (failed)
+            {
+                cout << error.message();
+                break;
+            }
+        }
+        else if (!recv_all(consumer, received.data(), received.size()) || !sink.write(i, received))
+        {
+            cout << "Failed to ingest blob " << i << endl;
+            failed = true;
+            break;
+        }
+
+        latencies.push_back((steady_ns() - header.sent_ns) / 1e6);
+        cout << '#';
+    }
+    // Unblock a sender that is stuck in send after a failure
+    close(consumer);
+    sender.join();
+    timer.stop();
+    cout << endl;
+
+    close(producer);
+    if (splicing)
+    {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    }
+    if (failed)
+        return 0.0;
+
+    spdlog::info("latency {:8.3f}ms avg, {:8.3f}ms p50, {:8.3f}ms p99, {:8.3f}ms max :ingest_{}",
+        accumulate(latencies.begin(), latencies.end(), 0.0) / max<size_t>(1, latencies.size()),
+        percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 1.0), ingest_tuning.mode);
+    return timer.elapsedSeconds();
+#else
+    cout << "Socket ingest is only supported on Linux" << endl;
+    return 0.0;
+#endif
+}
+
+// Writes (or reads) the blobs of a backend over and over, cycling through
+// count blob indices, until the soak duration has passed. Throughput and
+// latency percentiles per interval go to a CSV time series and intervals
+// with a blob slower than the stall threshold are flagged with a '!'.
+double soak(Blob& blob, int count, BlobSink const& sink, BlobSource const& source, string const& msg)
+{
+    last_soak_blobs = 0;
+    if (count == 0 || (!sink.write && !source.read))
+        return 0.0;
+
+    auto const sums(source.read ? load_checksums(source.file_name) : vector<uint32_t>());
+    ThroughputSeries series(soak_tuning.series_file + "_" + msg + ".csv", soak_tuning.interval, soak_tuning.stall_ms, blob.size());
+    auto const end(chrono::steady_clock::now() + chrono::duration<double>(soak_tuning.duration));
+    fill_blob(blob);
+    if (sink.write && verify_blobs)
+    {
+        // Every blob index gets the same blob
+        vector<uint32_t> sums(count, crc32c(blob.data(), blob.size()));
+        save_checksums(sink.file_name, sums);
+    }
+
+    Timer timer;
+    timer.start();
+    auto i(0);
+    for (; chrono::steady_clock::now() < end; ++i)
+    {
+        auto const started(steady_ns());
+        auto const ok(sink.write ? sink.write(i % count, blob) : source.read(i % count, blob));
+        auto const latency_ms((steady_ns() - started) / 1e6);
+        if (!ok)
+        {
+            cout << "Failed at blob " << i % count << endl;
+            return 0.0;
+        }
+        if (source.read)
+            verify_checksum(sums, i % count, blob);
+        for (auto stalled : series.record(latency_ms))
+            cout << (stalled ? '!' : '#') << flush;
+    }
+    series.finish();
+    timer.stop();
+    cout << endl;
+
+    spdlog::info("{} intervals, {} stalls over {}ms, {:7.1f} to {:7.1f}MB/s per interval, cv {:5.3f} :{}",
+        series.intervals(), series.stalls(), soak_tuning.stall_ms, series.min_throughput(), series.max_throughput(),
+        series.throughput_cv(), msg);
+    last_soak_blobs = i;
+    return timer.elapsedSeconds();
+}
+
+// Producers on nbr_of_threads threads append count Fake records to a group
+// commit log while readers tail the committed part of it through a mapping.
+// With --log-sync every record waits for its commit, otherwise only the last
+// record of each producer does and the commit latency of a record is taken
+// from the time of the batch that made it durable.
+double write_log(int count, string file_name, size_t batch_size)
+{
+#ifdef __linux__
+    auto const total(uint64_t(count) * sizeof(Fake));
+    if (total == 0 || !prepare_blob_file(file_name, total, true))
+        return 0.0;
+    int fd = open(file_name.c_str(), O_WRONLY);
+    if (fd < 0)
+    {
+        cout << strerror(errno);
+        return 0.0;
+    }
+    error_code error;
+    mio::mmap_source tail;
+    tail.map(file_name, error);
+    if (error)
+    {
+        cout << error.message();
+        close(fd);
+        return 0.0;
+    }
+
+    vector<double> latencies;
+    vector<pair<uint64_t, chrono::steady_clock::time_point>> pending; // Records appended without waiting
+    mutex latencies_mutex;
+    atomic<bool> writing{ true };
+    atomic<int> failures{ 0 };
+    Timer timer;
+    double secs(0.0);
+    size_t batches(0);
+    {
+        GroupCommitLog log(fd, max(batch_size, sizeof(Fake)), chrono::microseconds(log_tuning.delay_us));
+
+        vector<thread> readers;
+        for (auto r(0); r != log_tuning.readers; ++r)
+        {
+            readers.emplace_back([&]
+            {
+                uint64_t position(0);
+                while (position < total)
+                {
+                    auto const durable(log.durable());
+                    if (durable > position)
+                    {
+                        consumed += consume(tail.data() + position, durable - position);
+                        position = durable;
+                    }
+                    else if (!writing)
+                        break;
+                    else
+                        this_thread::yield();
+                }
+            });
+        }
+
+        timer.start();
+        run_threads(count, [&](int begin, int end)
+        {
+            Fake fake;
+            memset(fake.d1, '1', sizeof(fake.d1));
+            memset(fake.d2, '2', sizeof(fake.d2));
+            memset(fake.d3, '3', sizeof(fake.d3));
+            memset(fake.d4, '4', sizeof(fake.d4));
+            vector<double> commit_ms;
+            vector<pair<uint64_t, chrono::steady_clock::time_point>> appended;
+            uint64_t lsn(0);
+            for (auto i(begin); i != end; ++i)
+            {
+                memcpy(fake.d1, &i, sizeof(i));
+                auto const started(chrono::steady_clock::now());
+                lsn = log.append(reinterpret_cast<char const*>(&fake), sizeof(fake));
+                if (log_tuning.sync)
+                {
+                    if (!log.wait_durable(lsn))
+                        break;
+                    commit_ms.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - started).count());
+                }
+                else
+                {
+                    appended.emplace_back(lsn, started);
+                }
+            }
+            if (!log.wait_durable(lsn))
+                ++failures;
+            lock_guard<mutex> lock(latencies_mutex);
+            latencies.insert(latencies.end(), commit_ms.begin(), commit_ms.end());
+            pending.insert(pending.end(), appended.begin(), appended.end());
+        });
+        log.stop();
+
+        // Without --log-sync nobody waits per record, a record committed with
+        // the first batch that made the log durable past it
+        auto const& commits(log.commits());
+        for (auto const& record : pending)
+        {
+            auto const commit(lower_bound(commits.begin(), commits.end(), record.first,
+                [](GroupCommitLog::Commit const& c, uint64_t lsn) { return c.durable < lsn; }));
+            if (commit != commits.end())
+                latencies.push_back(chrono::duration<double, milli>(commit->at - record.second).count());
+        }
+        timer.stop();
+        writing = false;
+        for_each(readers.begin(), readers.end(), [](thread& t) { t.join(); });
+
+        error = log.error();
+        batches = log.batches();
+    }
+    close(fd);
+    if (error || failures != 0)
+    {
+        cout << "Log write failed " << error.message() << endl;
+        return 0.0;
+    }
+    secs = timer.elapsedSeconds();
+
+    if (latencies.empty())
+    {
+        spdlog::info("{} batches, {:8.1f} records of {}B per batch, {:9.0f} commits/s :write_log_{}KB",
+            batches, double(count) / max<size_t>(1, batches), sizeof(Fake), batches / secs, batch_size / 1024);
+    }
+    else
+    {
+        spdlog::info("{} batches, {:8.1f} records of {}B per batch, {:9.0f} commits/s, commit latency {:8.3f}ms p50 {:8.3f}ms p99 :write_log_{}KB",
+            batches, double(count) / max<size_t>(1, batches), sizeof(Fake), batches / secs,
+            percentile(latencies, 0.5), percentile(latencies, 0.99), batch_size / 1024);
+    }
+    return secs;
+#else
+    cout << "The group commit log is only supported on Linux" << endl;
+    return 0.0;
+#endif
+}
+
+// The sequential write and read of record_backend with records of type Record
+template<class Record>
+double seq_write_records(size_t blob_size, int count, string const& file_name)
+{
+    if (record_backend == "file")
+        return seq_write_file_stream<Record>(blob_size, count, file_name);
+    if (record_backend == "c_style")
+        return seq_write_c_style_io<Record>(blob_size, count, file_name);
+    if (record_backend == "mio")
+        return seq_write_mio<Record>(blob_size, count, file_name);
+    cout << "Unknown record backend " << record_backend << endl;
+    return 0.0;
+}
+
+template<class Record>
+double seq_read_records(size_t blob_size, int count, string const& file_name)
+{
+    if (record_backend == "file")
+        return seq_read_file_stream<Record>(blob_size, count, file_name);
+    if (record_backend == "c_style")
+        return seq_read_c_style_io<Record>(blob_size, count, file_name);
+    if (record_backend == "mio")
+        return seq_read_mio<Record>(blob_size, count, file_name);
+    cout << "Unknown record backend " << record_backend << endl;
+    return 0.0;
+}
+
+template<class Record>
+void print_records(double secs, string const& msg, size_t blob_size, int count)
+{
+    if (secs == 0.0)
+        return;
+    spdlog::info("{:12.0f} records/s of {}B in {} chunks :{}",
+        records_per_blob<Record>(blob_size) * count / secs, RecordSchema<Record>::size, RecordSchema<Record>::fields, msg);
+}
+
+void start_test(string const& msg)
+{
+    cout << "Running " << msg << " ..." << endl;
+    if (amp_accounting)
+    {
+        // Writeback of earlier tests must not be counted for this one
+        flush_file_systems();
+        device_written_at_start = device ? device->bytes_written() : 0;
+    }
+    checksum_timer.reset();
+    checksum_bytes = 0.0;
+    checksum_failures = 0;
+    instrumentation.start();
+    rss_sampler.start(chrono::milliseconds(rss_interval_ms));
+}
+
+// Counters of the test started by start_test, bytes is the payload moved by
+// the test or 0 when it doesn't move data
+void print_counters(string const& msg, int nbr_of_blobs, double bytes)
+{
+    // The RSS sampling runs inside the counters, its own cost is taken out
+    // of all but the perf counters
+    auto const rss(rss_sampler.stop());
+    auto c(instrumentation.stop());
+    c.cpu_secs -= rss.sampler.cpu_secs;
+    c.faults = c.faults - rss.sampler.faults;
+    c.io = c.io - rss.sampler.io;
+    auto const gb(bytes / 1e9);
+    last_counters = c;
+
+    if (mem_budget.bytes != 0)
+    {
+        spdlog::info("{:8.1f}MB rss avg, {:8.1f}MB max, {:8.1f}MB peak, {:5.1f}% of the {}MB budget, {:8.1f}MB block cache :{}",
+            rss.average / 1048576, rss.max / 1048576.0, rss.peak / 1048576.0, 100.0 * rss.peak / mem_budget.bytes,
+            mem_budget.bytes / 1048576, mem_budget.cache->GetUsage() / 1048576.0, msg);
+    }
+    else
+    {
+        spdlog::info("{:8.1f}MB rss avg, {:8.1f}MB max, {:8.1f}MB peak :{}",
+            rss.average / 1048576, rss.max / 1048576.0, rss.peak / 1048576.0, msg);
+    }
+
+    spdlog::info("{:7.2f}s cpu, {:7.2f} cpu-s/GB, {:9.1f} read/write calls/blob, dev r/w {:7.1f}/{:7.1f}MB, {:8} minor, {:6} major faults, {:9.1f}/blob :{}",
+        c.cpu_secs, gb > 0.0 ? c.cpu_secs / gb : 0.0, double(c.io.syscr + c.io.syscw) / nbr_of_blobs,
+        c.io.read_bytes / 1048576.0, c.io.write_bytes / 1048576.0,
+        c.faults.minor, c.faults.major, double(c.faults.minor + c.faults.major) / nbr_of_blobs, msg);
+
+    if (instrumentation.has_perf(perf_cycles) || instrumentation.has_perf(perf_context_switches))
+    {
+        auto const ipc(c.perf[perf_cycles] > 0.0 ? c.perf[perf_instructions] / c.perf[perf_cycles] : 0.0);
+        spdlog::info("{:10.3g} cycles, {:10.3g} instr, {:5.2f} IPC, {:10.3g} cache misses, {:8.0f} ctx switches, {:8.0f} faults :{}",
+            c.perf[perf_cycles], c.perf[perf_instructions], ipc, c.perf[perf_cache_misses],
+            c.perf[perf_context_switches], c.perf[perf_page_faults], msg);
+    }
+}
+
+void print_result(double secs, string const& msg, size_t blob_size, int nbr_of_blobs)
+{
+    spdlog::info("{:7.2f}s, {:7.1f}MB/s :{}", secs, nbr_of_blobs * (blob_size / 1048576) / secs, msg);
+    print_counters(msg, nbr_of_blobs, double(nbr_of_blobs) * blob_size);
+    if (verify_blobs && checksum_bytes > 0.0)
+    {
+        auto const crc_secs(checksum_timer.elapsedSeconds());
+        spdlog::info("{:7.2f}s crc32c ({}), {:7.1f}MB/s, {:5.1f}% of test, {} mismatches :{}",
+            crc_secs, crc32c_hardware() ? "sse4.2" : "table", checksum_bytes / 1048576 / crc_secs,
+            100.0 * crc_secs / secs, checksum_failures, msg);
+    }
+    last_secs_per_blob = secs / nbr_of_blobs;
+}
+
+// Metadata operations are compared with the per blob time of the last data test
+void print_ops(double secs, string const& msg, int nbr_of_ops)
+{
+    auto const us_per_op(secs * 1e6 / nbr_of_ops);
+    if (last_secs_per_blob > 0.0)
+    {
+        spdlog::info("{:7.2f}s, {:9.0f} ops/s, {:8.1f}us/op, {:5.1f}% of a blob transfer :{}",
+            secs, nbr_of_ops / secs, us_per_op, 100.0 * us_per_op / (last_secs_per_blob * 1e6), msg);
+    }
+    else
+    {
+        spdlog::info("{:7.2f}s, {:9.0f} ops/s, {:8.1f}us/op :{}", secs, nbr_of_ops / secs, us_per_op, msg);
+    }
+    print_counters(msg, nbr_of_ops, 0.0);
+}
+
+void print_extents(string const& file_name, string const& suffix, int nbr_of_blobs, string const& msg)
+{
+    int total(0), max_extents(0), files(0);
+    for (auto i(0); i != nbr_of_blobs; ++i)
+    {
+        auto extents = extent_count(blob_name(file_name, i, suffix));
+        if (extents < 0)
+            continue;
+        total += extents;
+        max_extents = max(max_extents, extents);
+        ++files;
+    }
+
+    if (files != 0)
+    {
+        spdlog::info("{:7.1f} extents/blob, max {} ({}) :{}", double(total) / files, max_extents, alloc_policy_name(alloc_policy), msg);
+    }
+}
+
+// Extents of a test that keeps all its blobs in one file
+void print_file_extents(string const& name, string const& msg)
+{
+    auto const extents(extent_count(name));
+    if (extents >= 0)
+    {
+        spdlog::info("{:7} extents in one file ({}) :{}", extents, alloc_policy_name(alloc_policy), msg);
+    }
+}
+
+uint64_t blobs_footprint(string const& file_name, string const& suffix, int nbr_of_blobs)
+{
+    uint64_t total(0);
+    for (auto i(0); i != nbr_of_blobs; ++i)
+    {
+        total += allocated_bytes(blob_name(file_name, i, suffix));
+    }
+    return total;
+}
+
+// Space and write amplification of a write test relative to its payload.
+// The process write-amp counts what the test dirtied, the device write-amp
+// what reached the disk from the whole machine during the test.
+void print_amplification(string const& msg, uint64_t footprint, size_t blob_size, int nbr_of_blobs)
+{
+    if (!amp_accounting)
+        return;
+
+    flush_file_systems();
+    auto const payload(double(nbr_of_blobs) * blob_size);
+    auto const process_written(double(last_counters.io.write_bytes));
+
+    if (device)
+    {
+        auto const device_written(double(device->bytes_written() - device_written_at_start));
+        spdlog::info("{:7.1f}MB on disk, space-amp {:5.2f}, {:7.1f}MB written, write-amp {:5.2f}, {} {:7.1f}MB, write-amp {:5.2f} :{}",
+            footprint / 1048576.0, footprint / payload, process_written / 1048576.0, process_written / payload,
+            device->name(), device_written / 1048576.0, device_written / payload, msg);
+    }
+    else
+    {
+        spdlog::info("{:7.1f}MB on disk, space-amp {:5.2f}, {:7.1f}MB written, write-amp {:5.2f} :{}",
+            footprint / 1048576.0, footprint / payload, process_written / 1048576.0, process_written / payload, msg);
+    }
+}
+
+// Overwrites size bytes of blob i at offset in a store that holds count
+// blobs. read gets a range back, flush makes everything durable and waits
+// for the background work the updates caused.
+struct BlobUpdater
+{
+    function<bool(int, size_t, char const*, size_t)> update;
+    function<bool(int, size_t, char*, size_t)> read;
+    function<bool()> flush;
+    function<uint64_t()> footprint;
+};
+
+// H5Fflush only hands the data to the OS, the sec2 file is synced as well
+bool sync_hdf5(H5::H5File& file)
+{
+    file.flush(H5F_SCOPE_LOCAL);
+#ifdef __linux__
+    void* handle(nullptr);
+    if (hdf5_tuning.driver == Hdf5Driver::sec2 && H5Fget_vfd_handle(file.getId(), H5P_DEFAULT, &handle) >= 0 && handle)
+        return fdatasync(*static_cast<int*>(handle)) == 0;
+#endif
+    return true;
+}
+
+// Creates count blobs in a backend and returns what updates them in place.
+// file pwrites into a file per blob, mio writes through a mapping of it,
+// hdf5 writes hyperslabs of a count x blob size dataset, tiledb writes
+// subarrays of a dense array of the same shape, rocks rewrites the chunk
+// values the range falls in and rocks_merge merges patches into them.
+BlobUpdater blob_updater(string const& backend, Blob& blob, int count, string const& file_name)
+{
+    BlobUpdater updater;
+    auto const chunk(min(update_tuning.chunk, blob.size()));
+
+    if (backend == "file")
+    {
+#ifdef __linux__
+        shared_ptr<vector<int>> fds(new vector<int>, [](vector<int>* fds)
+        {
+            for_each(fds->begin(), fds->end(), [](int fd) { close(fd); });
+            delete fds;
+        });
+        for (auto i(0); i != count; ++i)
+        {
+            auto const name(blob_name(file_name, i));
+            int fd = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+            {
+                cout << strerror(errno);
+                return BlobUpdater();
+            }
+            fds->push_back(fd);
+            fill_blob(blob);
+            if (pwrite(fd, blob.data(), blob.size(), 0) != ssize_t(blob.size()))
+            {
+                cout << "Short write of " << name << endl;
+                return BlobUpdater();
+            }
+        }
+        updater.update = [fds](int i, size_t offset, char const* data, size_t size)
+        {
+            auto const fd((*fds)[i]);
+            return pwrite(fd, data, size, offset) == ssize_t(size) && (!update_tuning.sync || fdatasync(fd) == 0);
+        };
+        updater.read = [fds](int i, size_t offset, char* data, size_t size)
+        {
+            return pread((*fds)[i], data, size, offset) == ssize_t(size);
+        };
+        updater.flush = [fds]
+        {
+            return all_of(fds->begin(), fds->end(), [](int fd) { return fdatasync(fd) == 0; });
+        };
+        updater.footprint = [file_name, count] { return blobs_footprint(file_name, "", count); };
+        return updater;
+#else
+        cout << "pwrite updates are only supported on Linux" << endl;
+        return updater;
+#endif
+    }
+
+    if (backend == "mio")
+    {
+        auto sinks(make_shared<vector<mio::mmap_sink>>(count));
+        for (auto i(0); i != count; ++i)
+        {
+            auto const name(blob_name(file_name, i, ".mio"));
+            error_code error;
+            if (!prepare_blob_file(name, blob.size(), true))
+                return BlobUpdater();
+            (*sinks)[i].map(name, error);
+            if (error)
+            {
+                cout << error.message();
+                return BlobUpdater();
+            }
+            fill_blob(blob);
+            memcpy((*sinks)[i].data(), blob.data(), blob.size());
+        }
+        updater.update = [sinks](int i, size_t offset, char const* data, size_t size)
+        {
+            memcpy((*sinks)[i].data() + offset, data, size);
+            if (!update_tuning.sync)
+                return true;
+            error_code error;
+            sync_range((*sinks)[i].data(), offset, size, error);
+            if (error)
+                cout << error.message() << endl;
+            return !error;
+        };
+        updater.read = [sinks](int i, size_t offset, char* data, size_t size)
+        {
+            memcpy(data, (*sinks)[i].data() + offset, size);
+            return true;
+        };
+        updater.flush = [sinks]
+        {
+            error_code error;
+            for (auto& sink : *sinks)
+            {
+                sync_range(sink.data(), 0, sink.size(), error);
+                if (error)
+                {
+                    cout << error.message() << endl;
+                    return false;
+                }
+            }
+            return true;
+        };
+        updater.footprint = [file_name, count] { return blobs_footprint(file_name, ".mio", count); };
+        return updater;
+    }
+
+    if (backend == "hdf5")
     {
-        auto name = file_name + to_string(i);
-        timer.start();
-
-        Context ctx;
-
-        ArraySchema schema(ctx, TILEDB_DENSE);
-
-        Domain domain(ctx);
-        domain.add_dimension(Dimension::create<int8_t>(ctx, "blob", { { 1, 1 } }, 1));
-
-        schema.set_domain(domain).set_order({ { TILEDB_ROW_MAJOR, TILEDB_ROW_MAJOR } });
-
-        schema.add_attribute(Attribute::create<vector<char>>(ctx, "data"));
+        try
+        {
+            auto const name(file_name + ".hdf5");
+            auto file(make_shared<H5::H5File>(name, H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, hdf5_access_props(hdf5_tuning)));
+            hsize_t dims[2]{ hsize_t(count), blob.size() };
+            hsize_t chunk_dims[2]{ 1, chunk };
+            H5::DSetCreatPropList props;
+            props.setChunk(2, chunk_dims);
+            auto dataset(make_shared<H5::DataSet>(file->createDataSet("blobs", H5::PredType::STD_I8LE, H5::DataSpace(2, dims), props)));
+
+            auto const transfer = [dataset](int i, size_t offset, char* data, size_t size, bool write)
+            {
+                try
+                {
+                    hsize_t start[2]{ hsize_t(i), offset };
+                    hsize_t extent[2]{ 1, size };
+                    auto space(dataset->getSpace());
+                    space.selectHyperslab(H5S_SELECT_SET, extent, start);
+                    H5::DataSpace memory(2, extent);
+                    if (write)
+                        dataset->write(data, H5::PredType::NATIVE_CHAR, memory, space);
+                    else
+                        dataset->read(data, H5::PredType::NATIVE_CHAR, memory, space);
+                    return true;
+                }
+                catch (H5::Exception const& e)
+                {
+                    cout << e.getDetailMsg() << endl;
+                    return false;
+                }
+            };
+            for (auto i(0); i != count; ++i)
+            {
+                fill_blob(blob);
+                if (!transfer(i, 0, blob.data(), blob.size(), true))
+                    return BlobUpdater();
+            }
+            updater.update = [file, transfer](int i, size_t offset, char const* data, size_t size)
+            {
+                return transfer(i, offset, const_cast<char*>(data), size, true) && (!update_tuning.sync || sync_hdf5(*file));
+            };
+            updater.read = [transfer](int i, size_t offset, char* data, size_t size)
+            {
+                return transfer(i, offset, data, size, false);
+            };
+            updater.flush = [file] { return sync_hdf5(*file); };
+            updater.footprint = [name] { return allocated_bytes(name); };
+            return updater;
+        }
+        catch (H5::Exception const& e)
+        {
+            cout << e.getDetailMsg() << endl;
+            return BlobUpdater();
+        }
+    }
 
-        Array::create(name, schema);
+    if (backend == "tiledb")
+    {
+        using namespace tiledb;
 
-        Array array(ctx, name, TILEDB_WRITE);
-        
-        vector<uint64_t> off(1, 0);
+        auto const uri(file_name + ".tiledb");
+        try
+        {
+            error_code error;
+            filesystem::remove_all(uri, error);
+            auto ctx(make_shared<Context>(tiledb_config()));
+            Domain domain(*ctx);
+            domain.add_dimension(Dimension::create<int64_t>(*ctx, "blob", { { 0, count - 1 } }, 1))
+                .add_dimension(Dimension::create<int64_t>(*ctx, "byte", { { 0, int64_t(blob.size()) - 1 } }, int64_t(chunk)));
+            ArraySchema schema(*ctx, TILEDB_DENSE);
+            schema.set_domain(domain).set_order({ { TILEDB_ROW_MAJOR, TILEDB_ROW_MAJOR } });
+            schema.add_attribute(Attribute::create<char>(*ctx, "data"));
+            Array::create(uri, schema);
+
+            // Every write is a fragment of its own, nothing is consolidated
+            auto const transfer = [ctx, uri](int i, size_t offset, char* data, size_t size, bool write)
+            {
+                try
+                {
+                    Array array(*ctx, uri, write ? TILEDB_WRITE : TILEDB_READ);
+                    vector<int64_t> subarray{ i, i, int64_t(offset), int64_t(offset + size) - 1 };
+                    uint64_t elements(size);
+                    Query query(*ctx, array);
+                    query.set_layout(TILEDB_ROW_MAJOR)
+                        .set_subarray(subarray)
+                        .set_buffer("data", data, elements);
+                    query.submit();
+                    array.close();
+                    return true;
+                }
+                catch (std::exception const& e)
+                {
+                    cout << e.what() << endl;
+                    return false;
+                }
+            };
+            for (auto i(0); i != count; ++i)
+            {
+                fill_blob(blob);
+                if (!transfer(i, 0, blob.data(), blob.size(), true))
+                    return BlobUpdater();
+            }
+            updater.update = [transfer](int i, size_t offset, char const* data, size_t size)
+            {
+                return transfer(i, offset, const_cast<char*>(data), size, true);
+            };
+            updater.read = [transfer](int i, size_t offset, char* data, size_t size)
+            {
+                return transfer(i, offset, data, size, false);
+            };
+            updater.flush = [] { return true; };
+            updater.footprint = [uri] { return allocated_bytes(uri); };
+            return updater;
+        }
+        catch (std::exception const& e)
+        {
+            cout << e.what() << endl;
+            return BlobUpdater();
+        }
+    }
 
-        Query query(ctx, array);
-        query.set_layout(TILEDB_ROW_MAJOR)
-            .set_buffer("data", off, blob);
-        query.submit();
-        array.close();
+    if (backend == "rocks" || backend == "rocks_merge")
+    {
+        auto const merge(backend == "rocks_merge");
+        error_code error;
+        filesystem::remove_all(file_name, error);
+        auto rocks(make_shared<ChunkedRocks>());
+        Status s = open_chunked_rocks(file_name, *rocks, merge ? make_shared<PatchMergeOperator>() : nullptr);
+        if (!s.ok())
+        {
+            cout << s.ToString();
+            return BlobUpdater();
+        }
+        for (auto i(0); i != count; ++i)
+        {
+            fill_blob(blob);
+            WriteBatch batch;
+            for (size_t offset(0), c(0); offset < blob.size(); offset += chunk, ++c)
+                batch.Put(rocks->chunks(), chunk_key(i, c), Slice(blob.data() + offset, min(chunk, blob.size() - offset)));
+            s = rocks->db->Write(WriteOptions(), &batch);
+            if (!s.ok())
+            {
+                cout << s.ToString();
+                return BlobUpdater();
+            }
+        }
 
-        timer.stop();
-        cout << '#';
+        // Calls f(key, offset in the chunk, offset in the range, size) for
+        // the chunks the range [offset, offset + size) falls in
+        auto const for_chunks = [chunk](int i, size_t offset, size_t size, function<bool(string const&, size_t, size_t, size_t)> const& f)
+        {
+            for (auto c(offset / chunk); c * chunk < offset + size; ++c)
+            {
+                auto const begin(max(offset, c * chunk));
+                auto const end(min(offset + size, (c + 1) * chunk));
+                if (!f(chunk_key(i, uint32_t(c)), begin - c * chunk, begin - offset, end - begin))
+                    return false;
+            }
+            return true;
+        };
+        updater.update = [rocks, merge, for_chunks](int i, size_t offset, char const* data, size_t size)
+        {
+            WriteBatch batch;
+            auto const ok(for_chunks(i, offset, size, [&](string const& key, size_t at, size_t from, size_t n)
+            {
+                if (merge)
+                {
+                    uint64_t const patch_at(at);
+                    string operand(reinterpret_cast<char const*>(&patch_at), sizeof(patch_at));
+                    operand.append(data + from, n);
+                    return batch.Merge(rocks->chunks(), key, operand).ok();
+                }
+                string value;
+                if (!rocks->db->Get(ReadOptions(), rocks->chunks(), key, &value).ok() || value.size() < at + n)
+                    return false;
+                memcpy(&value[at], data + from, n);
+                return batch.Put(rocks->chunks(), key, value).ok();
+            }));
+            WriteOptions write_options;
+            write_options.sync = update_tuning.sync;
+            return ok && rocks->db->Write(write_options, &batch).ok();
+        };
+        updater.read = [rocks, for_chunks](int i, size_t offset, char* data, size_t size)
+        {
+            return for_chunks(i, offset, size, [&](string const& key, size_t at, size_t from, size_t n)
+            {
+                string value;
+                if (!rocks->db->Get(ReadOptions(), rocks->chunks(), key, &value).ok() || value.size() < at + n)
+                    return false;
+                memcpy(data + from, value.data() + at, n);
+                return true;
+            });
+        };
+        updater.flush = [rocks]
+        {
+            // The compactions the updates triggered are part of their cost
+            return rocks->db->Flush(FlushOptions(), rocks->chunks()).ok() && wait_for_compactions(rocks->db, rocks->chunks());
+        };
+        updater.footprint = [file_name] { return allocated_bytes(file_name); };
+        return updater;
     }
-    cout << endl;
-    return timer.elapsedSeconds();
+
+    cout << "Unknown update backend " << backend << endl;
+    return updater;
 }
 
-double read_tiledb(Blob& blob, int count, string file_name)
+// Overwrites random byte ranges of the blobs of a backend in place. The
+// write amplification is what the process wrote for the updates, once they
+// are durable, over the bytes updated. The bytes come from /proc/self/io on
+// Linux, where page cache writes are counted per page they dirty, and are
+// the bytes passed to write calls elsewhere.
+double update_blobs(Blob& blob, int count, string const& backend, string const& file_name, string const& msg)
 {
-    using namespace tiledb;
+    if (count == 0 || blob.empty())
+        return 0.0;
+    auto updater(blob_updater(backend, blob, count, file_name));
+    if (!updater.update)
+        return 0.0;
+    if (!updater.flush())
+    {
+        cout << "Flushing " << backend << " failed" << endl;
+        return 0.0;
+    }
 
+    auto const size(min(update_tuning.size, blob.size()));
+    auto const updates(update_tuning.updates > 0 ? update_tuning.updates : 10 * count);
+    random_device rnd;
+    default_random_engine eng(rnd());
+    uniform_int_distribution<int> which(0, count - 1);
+    uniform_int_distribution<size_t> where(0, blob.size() - size);
+    // The new bytes of an update are taken from anywhere in the blob
+    fill_blob(blob);
+
+    auto const footprint_before(updater.footprint());
+    auto const io_before(io_counters());
+    vector<double> latencies;
+    latencies.reserve(updates);
+    int i(0);
+    size_t offset(0), data(0);
     Timer timer;
-    for (auto i(0); i != count; ++i)
+    for (auto u(0); u != updates; ++u)
     {
-        auto name = file_name + to_string(i);
+        i = which(eng);
+        offset = where(eng);
+        data = where(eng);
+        auto const started(steady_ns());
         timer.start();
-
-        Context ctx;
-
-        Array array(ctx, name, TILEDB_READ);
-
-        vector<int8_t> const subarray = { 1, 1 };
-
-        auto max_el_map = array.max_buffer_elements(subarray);
-        std::vector<uint64_t> off(max_el_map["data"].first);
-
-        Query query(ctx, array);
-        query.set_subarray(subarray)
-            .set_layout(TILEDB_ROW_MAJOR)
-            .set_buffer("data", off, blob);
-        query.submit();
-        array.close();
-
+        auto const ok(updater.update(i, offset, blob.data() + data, size));
         timer.stop();
-        cout << '#';
+        latencies.push_back((steady_ns() - started) / 1e6);
+        if (!ok)
+        {
+            cout << "Update of blob " << i << " failed" << endl;
+            return 0.0;
+        }
+        if ((u + 1) % max(1, updates / 64) == 0)
+            cout << '#';
     }
     cout << endl;
-    return timer.elapsedSeconds();
-}
+    if (!updater.flush())
+    {
+        cout << "Flushing " << backend << " failed" << endl;
+        return 0.0;
+    }
+    auto const io(io_counters() - io_before);
+    auto const growth(double(updater.footprint()) - double(footprint_before));
 
-void emptyWorkingSet()
-{
-#ifdef _WIN32
-    ::EmptyWorkingSet(::GetCurrentProcess());
-#endif // _WIN32
-}
-    
+    if (verify_blobs)
+    {
+        Blob check(size);
+        if (!updater.read(i, offset, check.data(), size) || !equal(check.begin(), check.end(), blob.begin() + data))
+        {
+            cout << "The last update of blob " << i << " is not in " << backend << endl;
+            return 0.0;
+        }
+    }
 
-void print_result(double secs, string const& msg, size_t blob_size, int nbr_of_blobs)
-{
-    spdlog::info("{:7.2f}s, {:7.1f}MB/s :{}", secs, nbr_of_blobs * (blob_size / 1048576) / secs, msg);
+#ifdef __linux__
+    auto const written(double(io.write_bytes));
+#else
+    auto const written(double(io.wchar));
+#endif
+    auto const payload(double(updates) * size);
+    spdlog::info("{} updates of {}B, latency {:8.3f}ms p50 {:8.3f}ms p99 {:8.3f}ms max, {:8.1f}MB written, write-amp {:7.2f}, {:+8.1f}MB on disk :{}",
+        updates, size, percentile(latencies, 0.5), percentile(latencies, 0.99), *max_element(latencies.begin(), latencies.end()),
+        written / 1048576, written / payload, growth / 1048576, msg);
+    return timer.elapsedSeconds();
 }
 
 int main(int argc, char* argv[])
@@ -848,6 +3788,33 @@ int main(int argc, char* argv[])
     os << "21\t read_cereal\n";
     os << "22\t write_tiledb\n";
     os << "23\t read_tiledb\n";
+    os << "24\t write_direct_io\n";
+    os << "25\t read_direct_io\n";
+    os << "26\t meta_create\n";
+    os << "27\t meta_open\n";
+    os << "28\t meta_stat\n";
+    os << "29\t meta_unlink\n";
+    os << "30\t read_pread\n";
+    os << "31\t scan_rocks\n";
+    os << "32\t write_rocks_chunked\n";
+    os << "33\t read_rocks_chunked\n";
+    os << "34\t write_dedup\n";
+    os << "35\t read_dedup\n";
+    os << "36\t seq_write_vectored\n";
+    os << "37\t seq_read_vectored\n";
+    os << "38\t write_hdf5_store\n";
+    os << "39\t read_hdf5_store\n";
+    os << "40\t read_cached\n";
+    os << "41\t read_prefetched\n";
+    os << "42\t read_numa\n";
+    os << "43\t ingest\n";
+    os << "44\t soak_write\n";
+    os << "45\t soak_read\n";
+    os << "46\t write_log\n";
+    os << "47\t seq_write_records\n";
+    os << "48\t seq_read_records\n";
+    os << "49\t mem_budget\n";
+    os << "50\t update\n";
 
     args::ArgumentParser parser("This is a io performance test program.", os.str());
     args::HelpFlag help(parser, "help", "Display this help menu", { 'h', "help" });
@@ -856,6 +3823,65 @@ int main(int argc, char* argv[])
     args::ValueFlag<int> blobSize(parser, "blobSize", "Size of a blob [MB]", { 's' }, 1048576 * 15);
     args::ValueFlag<std::string> dir(parser, "dir", "Output directory", { 'd', "dir" }, "D:/disk-test");
     args::Flag randomFlag(parser, "random", "Fill blob with random values and unique file names", { 'r' }, false);
+    args::ValueFlag<std::string> allocPolicy(parser, "alloc", "File preallocation: none, fallocate, keep_size, posix_fallocate or truncate", { "alloc" }, "none");
+    args::ValueFlag<int> shardLevels(parser, "levels", "Number of hashed directory levels for per blob files", { "shard-levels" }, 0);
+    args::ValueFlag<int> shardFanout(parser, "fanout", "Number of sub directories per shard level", { "shard-fanout" }, 256);
+    args::ValueFlag<int> threads(parser, "threads", "Number of threads in the multi-threaded tests", { 't', "threads" }, 1);
+    args::ValueFlag<std::string> mmapModes(parser, "modes", "mio mapping modes: populate, sequential, willneed, hugepage, persistent", { "mmap" }, "");
+    args::Flag ampFlag(parser, "amp", "Measure space and write amplification of the write tests", { "amp" }, false);
+    args::Flag rocksStringKeys(parser, "rocks-string-keys", "Use to_string(i) instead of big endian RocksDB keys", { "rocks-string-keys" }, false);
+    args::ValueFlag<int> rocksCache(parser, "MB", "RocksDB block cache size, 0 for no cache", { "rocks-cache" }, -1);
+    args::ValueFlag<std::string> rocksCacheType(parser, "type", "RocksDB block cache: lru or hyperclock", { "rocks-cache-type" }, "lru");
+    args::ValueFlag<int> rocksReadahead(parser, "KB", "RocksDB readahead size", { "rocks-readahead" }, 0);
+    args::Flag rocksNoFillCache(parser, "rocks-no-fill-cache", "Don't fill the RocksDB block cache on reads", { "rocks-no-fill-cache" }, false);
+    args::Flag rocksZeroCopy(parser, "rocks-zero-copy", "Consume pinned RocksDB values instead of copying them", { "rocks-zero-copy" }, false);
+    args::ValueFlag<int> rocksChunk(parser, "KB", "RocksDB chunk size, 0 runs 64, 256, 1024 and 4096", { "rocks-chunk" }, 0);
+    args::Flag verifyFlag(parser, "verify", "Store a CRC32C per blob on write and verify it on read", { "verify" }, false);
+    args::ValueFlag<int> dedupAvg(parser, "KB", "Average dedup chunk size", { "dedup-avg" }, 8);
+    args::ValueFlag<int> dedupEdits(parser, "edits", "Edits between two versions of a blob in the dedup test", { "dedup-edits" }, 16);
+    args::Flag dedupRocks(parser, "dedup-rocks", "Store unique dedup chunks in RocksDB instead of a pack file", { "dedup-rocks" }, false);
+    args::ValueFlag<int> iovBatch(parser, "iovecs", "iovecs per pwritev/preadv call", { "iov-batch" }, 1024);
+    args::ValueFlag<std::string> rwfFlags(parser, "flags", "RWF_ flags of the vectored tests: hipri, dsync, sync, nowait", { "rwf" }, "");
+    args::ValueFlag<std::string> hdf5Driver(parser, "driver", "HDF5 store file driver: sec2, core or direct", { "hdf5-driver" }, "sec2");
+    args::ValueFlag<int> hdf5Page(parser, "KB", "HDF5 store paged aggregation page size, 0 for none", { "hdf5-page" }, 0);
+    args::ValueFlag<int> hdf5PageBuffer(parser, "MB", "HDF5 store page buffer size", { "hdf5-page-buffer" }, 0);
+    args::ValueFlag<int> hdf5MetaCache(parser, "MB", "HDF5 store metadata cache size", { "hdf5-meta-cache" }, 0);
+    args::ValueFlag<int> hdf5ChunkCache(parser, "MB", "HDF5 store chunk cache size per dataset", { "hdf5-chunk-cache" }, 0);
+    args::ValueFlag<int> hdf5Chunk(parser, "KB", "HDF5 store chunk size, 0 for contiguous datasets", { "hdf5-chunk" }, 0);
+    args::ValueFlag<std::string> cacheBackend(parser, "backend", "Backend behind the read cache: file, c_style, mio, hdf5 or rocks", { "cache-backend" }, "file");
+    args::ValueFlag<int> cacheMb(parser, "MB", "Read cache size", { "cache-mb" }, 256);
+    args::ValueFlag<int> cacheShards(parser, "shards", "Read cache shards, 0 for automatic", { "cache-shards" }, 0);
+    args::Flag cacheNoAdmission(parser, "cache-no-admission", "Admit every blob to the read cache instead of using TinyLFU", { "cache-no-admission" }, false);
+    args::Flag cacheCompress(parser, "cache-compress", "Keep zlib compressed blobs in the read cache", { "cache-compress" }, false);
+    args::ValueFlag<double> cacheSkew(parser, "skew", "Zipf skew of the read cache requests, 0 for uniform", { "cache-skew" }, 0.99);
+    args::ValueFlag<int> cacheReads(parser, "reads", "Read cache requests, 0 for ten per blob", { "cache-reads" }, 0);
+    args::ValueFlag<std::string> prefetchBackend(parser, "backend", "Backend of the prefetch test: file, c_style, mio, hdf5 or rocks", { "prefetch-backend" }, "file");
+    args::ValueFlag<std::string> prefetchMode(parser, "mode", "Prefetching: none, threads or fadvise", { "prefetch" }, "threads");
+    args::ValueFlag<int> prefetchDepth(parser, "blobs", "Number of blobs read ahead", { "prefetch-depth" }, 4);
+    args::ValueFlag<int> prefetchThreads(parser, "threads", "Background readers of the threads prefetching", { "prefetch-threads" }, 2);
+    args::ValueFlag<int> numaNode(parser, "node", "Pin threads and bind the blob buffers to a NUMA node", { "numa" }, -1);
+    args::Flag numaSpread(parser, "numa-spread", "Spread worker threads round robin over the NUMA nodes", { "numa-spread" }, false);
+    args::ValueFlag<std::string> numaBackend(parser, "backend", "Backend of the NUMA test: file, c_style, mio, cereal, hdf5 or rocks", { "numa-backend" }, "mio");
+    args::ValueFlag<std::string> ingestMode(parser, "mode", "Ingest into files with splice or recv, or recv into a backend: file, c_style, mio, hdf5 or rocks", { "ingest" }, "splice");
+    args::ValueFlag<std::string> ingestTransport(parser, "transport", "Ingest over a loopback tcp or unix socket", { "ingest-transport" }, "tcp");
+    args::ValueFlag<double> duration(parser, "seconds", "Run the soak tests for this long, they are skipped without it", { "duration" }, 0.0);
+    args::ValueFlag<double> soakInterval(parser, "seconds", "Soak time series interval", { "soak-interval" }, 1.0);
+    args::ValueFlag<double> soakStall(parser, "ms", "Blob latency that flags an interval as a stall", { "soak-stall" }, 1000.0);
+    args::ValueFlag<std::string> soakBackend(parser, "backend", "Backend of the soak tests: file, c_style, mio, hdf5 or rocks", { "soak-backend" }, "rocks");
+    args::ValueFlag<std::string> soakFile(parser, "prefix", "Prefix of the soak time series files", { "soak-file" }, "soak");
+    args::ValueFlag<int> logRecords(parser, "records", "Records appended to the group commit log", { "log-records" }, 100000);
+    args::ValueFlag<int> logBatch(parser, "KB", "Group commit batch size, 0 runs 4, 64 and 1024", { "log-batch" }, 0);
+    args::Flag logSync(parser, "log-sync", "Wait for the commit of every log record", { "log-sync" }, false);
+    args::ValueFlag<int> logReaders(parser, "readers", "Threads tailing the log", { "log-readers" }, 1);
+    args::ValueFlag<int> logDelay(parser, "us", "Longest wait for a group commit batch", { "log-delay" }, 1000);
+    args::ValueFlag<int> memBudget(parser, "MB", "Memory budget of RocksDB, HDF5 and TileDB, test 49 runs 64, 256 and 1024 without it", { "mem-budget" }, 0);
+    args::ValueFlag<int> rssInterval(parser, "ms", "Resident set size sampling interval, 0 to sample only at the start and end of a test", { "rss-interval" }, 20);
+    args::ValueFlag<std::string> updateBackend(parser, "backend", "Backend of the update test: file, mio, hdf5, tiledb, rocks or rocks_merge, all when not given", { "update-backend" }, "");
+    args::ValueFlag<int> updateSize(parser, "bytes", "Bytes overwritten per update", { "update-size" }, 4096);
+    args::ValueFlag<int> nbrOfUpdates(parser, "updates", "Number of updates, 0 for ten per blob", { "updates" }, 0);
+    args::Flag updateSync(parser, "update-sync", "Make every update durable before the next", { "update-sync" }, false);
+    args::ValueFlag<int> updateChunk(parser, "KB", "RocksDB chunk, HDF5 chunk and TileDB tile size of the update test", { "update-chunk" }, 64);
+    args::ValueFlag<std::string> recordBackend(parser, "backend", "Backend of the record tests: file, c_style or mio", { "record-backend" }, "c_style");
     args::PositionalList<int> tests(parser, "tests", "Tests to run");
 
     ostringstream cmdLine;
@@ -886,20 +3912,146 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    random = randomFlag.Get();
+    random_blobs = randomFlag.Get();
+    if (!parse_alloc_policy(args::get(allocPolicy), alloc_policy))
+    {
+        cerr << "Unknown allocation policy " << args::get(allocPolicy) << endl;
+        return 1;
+    }
+    if (args::get(shardLevels) < 0 || args::get(shardFanout) < 2)
+    {
+        cerr << "--shard-levels must be 0 or more and --shard-fanout 2 or more" << endl;
+        return 1;
+    }
+    blob_namespace = BlobNamespace(args::get(shardLevels), args::get(shardFanout));
+    nbr_of_threads = max(1, args::get(threads));
+    string unknown_mode;
+    if (!parse_mmap_tuning(args::get(mmapModes), mmap_tuning, unknown_mode))
+    {
+        cerr << "Unknown mmap mode " << unknown_mode << endl;
+        return 1;
+    }
+    amp_accounting = ampFlag.Get();
+    verify_blobs = verifyFlag.Get();
+    dedup_tuning.avg_chunk = size_t(max(1, args::get(dedupAvg))) * 1024;
+    dedup_tuning.edits = max(0, args::get(dedupEdits));
+    dedup_tuning.rocks = dedupRocks.Get();
+    vectored_tuning.batch = max(int(record_chunks.size()), args::get(iovBatch));
+    string unknown_rwf;
+    if (!parse_rwf_flags(args::get(rwfFlags), vectored_tuning.flags, unknown_rwf))
+    {
+        cerr << "Unknown or unsupported RWF flag " << unknown_rwf << endl;
+        return 1;
+    }
+    if (!parse_hdf5_driver(args::get(hdf5Driver), hdf5_tuning.driver))
+    {
+        cerr << "Unknown HDF5 driver " << args::get(hdf5Driver) << endl;
+        return 1;
+    }
+    hdf5_tuning.page_size = size_t(max(0, args::get(hdf5Page))) * 1024;
+    hdf5_tuning.page_buffer = size_t(max(0, args::get(hdf5PageBuffer))) * 1024 * 1024;
+    hdf5_tuning.meta_cache = size_t(max(0, args::get(hdf5MetaCache))) * 1024 * 1024;
+    hdf5_tuning.chunk_cache = size_t(max(0, args::get(hdf5ChunkCache))) * 1024 * 1024;
+    hdf5_tuning.chunk_size = size_t(max(0, args::get(hdf5Chunk))) * 1024;
+    auto const hdf5_unbudgeted(hdf5_tuning);
+    set_mem_budget(size_t(max(0, args::get(memBudget))) * 1048576, hdf5_unbudgeted);
+    rss_interval_ms = max(0, args::get(rssInterval));
+    cache_tuning.backend = args::get(cacheBackend);
+    cache_tuning.capacity = size_t(max(0, args::get(cacheMb))) * 1024 * 1024;
+    cache_tuning.shards = max(0, args::get(cacheShards));
+    cache_tuning.admission = !cacheNoAdmission.Get();
+    cache_tuning.compress = cacheCompress.Get();
+    cache_tuning.skew = max(0.0, args::get(cacheSkew));
+    cache_tuning.reads = max(0, args::get(cacheReads));
+    prefetch_tuning.backend = args::get(prefetchBackend);
+    if (args::get(prefetchMode) == "none")
+        prefetch_tuning.mode = PrefetchMode::none;
+    else if (args::get(prefetchMode) == "threads")
+        prefetch_tuning.mode = PrefetchMode::threads;
+    else if (args::get(prefetchMode) == "fadvise")
+        prefetch_tuning.mode = PrefetchMode::fadvise;
+    else
+    {
+        cerr << "Unknown prefetch mode " << args::get(prefetchMode) << endl;
+        return 1;
+    }
+    prefetch_tuning.depth = max(1, args::get(prefetchDepth));
+    prefetch_tuning.threads = max(1, args::get(prefetchThreads));
+    record_backend = args::get(recordBackend);
+    update_tuning.size = size_t(max(1, args::get(updateSize)));
+    update_tuning.updates = max(0, args::get(nbrOfUpdates));
+    update_tuning.sync = updateSync.Get();
+    update_tuning.chunk = size_t(max(1, args::get(updateChunk))) * 1024;
+    log_tuning.records = max(0, args::get(logRecords));
+    log_tuning.sync = logSync.Get();
+    log_tuning.readers = max(0, args::get(logReaders));
+    log_tuning.delay_us = max(1, args::get(logDelay));
+    soak_tuning.duration = max(0.0, args::get(duration));
+    soak_tuning.interval = max(0.001, args::get(soakInterval));
+    soak_tuning.stall_ms = args::get(soakStall);
+    if (soak_tuning.stall_ms < 0.0)
+    {
+        cerr << "--soak-stall must be 0 or more" << endl;
+        return 1;
+    }
+    soak_tuning.backend = args::get(soakBackend);
+    soak_tuning.series_file = args::get(soakFile);
+    ingest_tuning.mode = args::get(ingestMode);
+    if (args::get(ingestTransport) == "tcp")
+        ingest_tuning.transport = IngestTransport::tcp;
+    else if (args::get(ingestTransport) == "unix")
+        ingest_tuning.transport = IngestTransport::unix_socket;
+    else
+    {
+        cerr << "Unknown ingest transport " << args::get(ingestTransport) << endl;
+        return 1;
+    }
+    numa_node = args::get(numaNode);
+    numa_spread = numaSpread.Get();
+    if (numa_node >= numa_nodes())
+    {
+        cerr << "There are only " << numa_nodes() << " NUMA nodes" << endl;
+        return 1;
+    }
+    rocks_tuning.string_keys = rocksStringKeys.Get();
+    rocks_tuning.cache_mb = args::get(rocksCache);
+    rocks_tuning.hyper_clock = args::get(rocksCacheType) == "hyperclock";
+    rocks_tuning.readahead = size_t(max(0, args::get(rocksReadahead))) * 1024;
+    rocks_tuning.fill_cache = !rocksNoFillCache.Get();
+    rocks_tuning.zero_copy = rocksZeroCopy.Get();
+    vector<size_t> rocks_chunk_kbs{ 64, 256, 1024, 4096 };
+    vector<size_t> log_batch_kbs{ 4, 64, 1024 };
+    vector<size_t> mem_budget_mbs{ 64, 256, 1024 };
+    vector<string> update_backends{ "file", "mio", "hdf5", "tiledb", "rocks", "rocks_merge" };
+    if (!args::get(updateBackend).empty())
+        update_backends.assign(1, args::get(updateBackend));
+    if (args::get(memBudget) > 0)
+        mem_budget_mbs.assign(1, args::get(memBudget));
+    if (args::get(logBatch) > 0)
+        log_batch_kbs.assign(1, args::get(logBatch));
+    if (args::get(rocksChunk) > 0)
+        rocks_chunk_kbs.assign(1, args::get(rocksChunk));
 
     auto t = args::get(tests);
     int const nbr_of_blobs = args::get(nbrOfBlobs);
     int const blob_size = args::get(blobSize);
 
     spdlog::info("===== Start test with a rnd ({}) blob of size {} bytes and with {} nbr of blobs ============",
-        random, blob_size, nbr_of_blobs);
+        random_blobs, blob_size, nbr_of_blobs);
     spdlog::info(cmdLine.str());
 
     Blob blob(blob_size, '1');
 
+    if (numa_node >= 0)
+    {
+        pin_thread_to_node(numa_node);
+        bind_to_node(blob.data(), blob.size(), numa_node);
+        bind_to_node(buf.get(), bufsize, numa_node);
+        spdlog::info("Threads and buffers on NUMA node {} of {}", numa_node, numa_nodes());
+    }
+
     srand(time(0));
-    auto extension = random ? "_" + std::to_string(rand()) + "-" : "";
+    auto extension = random_blobs ? "_" + std::to_string(rand()) + "-" : "";
 
     Timer timer;
     timer.start();
@@ -908,167 +4060,483 @@ int main(int argc, char* argv[])
 
     auto path(args::get(dir));
 
+    if (amp_accounting)
+    {
+        device = make_unique<DeviceStats>(path);
+        if (!device->valid())
+        {
+            cout << "No block device found for " << path << ", only process write bytes are reported" << endl;
+            device.reset();
+        }
+    }
+
+    if (blob_namespace.levels() != 0)
+    {
+        error_code error;
+        blob_namespace.create_dirs(path, size_t(max(0, nbr_of_blobs)), error);
+        if (error)
+        {
+            cerr << "Failed to create shard directories: " << error.message() << endl;
+            return 1;
+        }
+    }
+
     if (t.empty() || find(t.begin(), t.end(), 1) != t.end())
     {
-        cout << "Running write_rocks ..." << endl;
+        start_test("write_rocks");
         secs = write_rocks(blob, nbr_of_blobs, path + "/rocksdb");
         print_result(secs, "write_rocks", blob.size(), nbr_of_blobs);
+        print_amplification("write_rocks", allocated_bytes(path + "/rocksdb"), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 2) != t.end())
     {
-        cout << "Running write_file_stream ..." << endl;
+        start_test("write_file_stream");
         secs = write_file_stream(blob, nbr_of_blobs, path + "/write_file_stream" + extension);
         print_result(secs, "write_file_stream", blob.size(), nbr_of_blobs);
+        print_extents(path + "/write_file_stream" + extension, "", nbr_of_blobs, "write_file_stream");
+        print_amplification("write_file_stream", blobs_footprint(path + "/write_file_stream" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 3) != t.end())
     {
-        cout << "Running write_c_style_io ..." << endl;
+        start_test("write_c_style_io");
         secs = write_c_style_io(blob, nbr_of_blobs, path + "/write_c_style_io" + extension);
         print_result(secs, "write_c_style_io", blob.size(), nbr_of_blobs);
+        print_extents(path + "/write_c_style_io" + extension, "", nbr_of_blobs, "write_c_style_io");
+        print_amplification("write_c_style_io", blobs_footprint(path + "/write_c_style_io" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
     
     if (t.empty() || find(t.begin(), t.end(), 4) != t.end())
     {
-        cout << "Running read_rocks ..." << endl;
+        start_test("read_rocks");
         secs = read_rocks(blob, nbr_of_blobs, path + "/rocksdb");
         print_result(secs, "read_rocks", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 5) != t.end())
     {
-        cout << "Running read_file_stream ..." << endl;
+        start_test("read_file_stream");
         secs = read_file_stream(blob, nbr_of_blobs, path + "/write_file_stream" + extension);
         print_result(secs, "read_file_stream", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 6) != t.end())
     {
-        cout << "Running read_c_style_io ..." << endl;
+        start_test("read_c_style_io");
         secs = read_c_style_io(blob, nbr_of_blobs, path + "/write_c_style_io" + extension);
         print_result(secs, "read_c_style_io", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 7) != t.end())
     {
-        cout << "Running seq_write_file_stream ..." << endl;
+        start_test("seq_write_file_stream");
         secs = seq_write_file_stream(blob.size(), nbr_of_blobs, path + "/seq_write_file_stream" + extension);
         print_result(secs, "seq_write_file_stream", blob.size(), nbr_of_blobs);
+        print_extents(path + "/seq_write_file_stream" + extension, "", nbr_of_blobs, "seq_write_file_stream");
+        print_amplification("seq_write_file_stream", blobs_footprint(path + "/seq_write_file_stream" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 8) != t.end())
     {
-        cout << "Running seq_write_c_style_io ..." << endl;
+        start_test("seq_write_c_style_io");
         secs = seq_write_c_style_io(blob.size(), nbr_of_blobs, path + "/seq_write_c_style_io" + extension);
         print_result(secs, "seq_write_c_style_io", blob.size(), nbr_of_blobs);
+        print_extents(path + "/seq_write_c_style_io" + extension, "", nbr_of_blobs, "seq_write_c_style_io");
+        print_amplification("seq_write_c_style_io", blobs_footprint(path + "/seq_write_c_style_io" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 9) != t.end())
     {
-        cout << "Running seq_read_file_stream ..." << endl;
+        start_test("seq_read_file_stream");
         secs = seq_read_file_stream(blob.size(), nbr_of_blobs, path + "/seq_write_file_stream" + extension);
         print_result(secs, "seq_read_file_stream", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 10) != t.end())
     {
-        cout << "Running seq_read_c_style_io ..." << endl;
+        start_test("seq_read_c_style_io");
         secs = seq_read_c_style_io(blob.size(), nbr_of_blobs, path + "/seq_write_c_style_io" + extension);
         print_result(secs, "seq_read_c_style_io", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 11) != t.end())
     {
-        cout << "Running write_hdf5 ..." << endl;
+        start_test("write_hdf5");
         secs = write_hdf5(blob, nbr_of_blobs, path + "/write_hdf5" + extension);
         print_result(secs, "write_hdf5", blob.size(), nbr_of_blobs);
+        print_amplification("write_hdf5", blobs_footprint(path + "/write_hdf5" + extension, ".hdf5", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 12) != t.end())
     {
-        cout << "Running read_hdf5 ..." << endl;
+        start_test("read_hdf5");
         secs = read_hdf5(blob, nbr_of_blobs, path + "/write_hdf5" + extension);
         print_result(secs, "read_hdf5", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 13) != t.end())
     {
-        cout << "Running seq_write_hdf5 ..." << endl;
+        start_test("seq_write_hdf5");
         secs = seq_write_hdf5(blob.size(), nbr_of_blobs, path + "/seq_write_hdf5" + extension);
         print_result(secs, "seq_write_hdf5", blob.size(), nbr_of_blobs);
+        print_amplification("seq_write_hdf5", blobs_footprint(path + "/seq_write_hdf5" + extension, ".hdf5", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 14) != t.end())
     {
-        cout << "Running write_mio ..." << endl;
+        start_test("write_mio");
         secs = write_mio(blob, nbr_of_blobs, path + "/write_mio" + extension);
         print_result(secs, "write_mio", blob.size(), nbr_of_blobs);
+        if (mmap_tuning.persistent)
+            print_file_extents(path + "/write_mio" + extension + "persistent.mio", "write_mio");
+        else
+            print_extents(path + "/write_mio" + extension, ".mio", nbr_of_blobs, "write_mio");
+        print_amplification("write_mio", blobs_footprint(path + "/write_mio" + extension, ".mio", nbr_of_blobs)
+            + allocated_bytes(path + "/write_mio" + extension + "persistent.mio"), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 15) != t.end())
     {
-        cout << "Running read_mio ..." << endl;
+        start_test("read_mio");
         secs = read_mio(blob, nbr_of_blobs, path + "/write_mio" + extension);
         print_result(secs, "read_mio", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 16) != t.end())
     {
-        cout << "Running seq_write_mio ..." << endl;
+        start_test("seq_write_mio");
         secs = seq_write_mio(blob.size(), nbr_of_blobs, path + "/seq_write_mio" + extension);
         print_result(secs, "seq_write_mio", blob.size(), nbr_of_blobs);
+        print_extents(path + "/seq_write_mio" + extension, ".mio", nbr_of_blobs, "seq_write_mio");
+        print_amplification("seq_write_mio", blobs_footprint(path + "/seq_write_mio" + extension, ".mio", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 17) != t.end())
     {
-        cout << "Running seq_read_mio ..." << endl;
+        start_test("seq_read_mio");
         secs = seq_read_mio(blob.size(), nbr_of_blobs, path + "/seq_write_mio" + extension);
         print_result(secs, "seq_read_mio", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 18) != t.end())
     {
-        cout << "Running seq_write_cereal ..." << endl;
+        start_test("seq_write_cereal");
         secs = seq_write_cereal(blob.size(), nbr_of_blobs, path + "/seq_write_cereal" + extension);
         print_result(secs, "seq_write_cereal", blob.size(), nbr_of_blobs);
+        print_amplification("seq_write_cereal", blobs_footprint(path + "/seq_write_cereal" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 19) != t.end())
     {
-        cout << "Running seq_read_cereal ..." << endl;
+        start_test("seq_read_cereal");
         secs = seq_read_cereal(blob.size(), nbr_of_blobs, path + "/seq_write_cereal" + extension);
         print_result(secs, "seq_read_cereal", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 20) != t.end())
     {
-        cout << "Running write_cereal ..." << endl;
+        start_test("write_cereal");
         secs = write_cereal(blob, nbr_of_blobs, path + "/write_cereal" + extension);
         print_result(secs, "write_cereal", blob.size(), nbr_of_blobs);
+        print_amplification("write_cereal", blobs_footprint(path + "/write_cereal" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 21) != t.end())
     {
-        cout << "Running read_cereal ..." << endl;
+        start_test("read_cereal");
         secs = read_cereal(blob, nbr_of_blobs, path + "/write_cereal" + extension);
         print_result(secs, "read_cereal", blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 22) != t.end())
     {
-        cout << "Running write_tiledb ..." << endl;
+        start_test("write_tiledb");
         secs = write_tiledb(blob, nbr_of_blobs, path + "/write_tiledb" + extension);
         print_result(secs, "write_tiledb", blob.size(), nbr_of_blobs);
+        print_amplification("write_tiledb", blobs_footprint(path + "/write_tiledb" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
     }
 
     if (t.empty() || find(t.begin(), t.end(), 23) != t.end())
     {
-        cout << "Running read_tiledb ..." << endl;
+        start_test("read_tiledb");
         secs = read_tiledb(blob, nbr_of_blobs, path + "/write_tiledb" + extension);
         print_result(secs, "read_tiledb", blob.size(), nbr_of_blobs);
     }
 
+    if (t.empty() || find(t.begin(), t.end(), 24) != t.end())
+    {
+        start_test("write_direct_io");
+        secs = write_direct_io(blob, nbr_of_blobs, path + "/write_direct_io" + extension);
+        print_result(secs, "write_direct_io", blob.size(), nbr_of_blobs);
+        print_extents(path + "/write_direct_io" + extension, "", nbr_of_blobs, "write_direct_io");
+        print_amplification("write_direct_io", blobs_footprint(path + "/write_direct_io" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 25) != t.end())
+    {
+        start_test("read_direct_io");
+        secs = read_direct_io(blob, nbr_of_blobs, path + "/write_direct_io" + extension);
+        print_result(secs, "read_direct_io", blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 26) != t.end())
+    {
+        start_test("meta_create");
+        secs = meta_files(MetaOp::create, nbr_of_blobs, path + "/meta" + extension);
+        print_ops(secs, "meta_create", nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 27) != t.end())
+    {
+        start_test("meta_open");
+        secs = meta_files(MetaOp::open, nbr_of_blobs, path + "/meta" + extension);
+        print_ops(secs, "meta_open", nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 28) != t.end())
+    {
+        start_test("meta_stat");
+        secs = meta_files(MetaOp::stat, nbr_of_blobs, path + "/meta" + extension);
+        print_ops(secs, "meta_stat", nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 29) != t.end())
+    {
+        start_test("meta_unlink");
+        secs = meta_files(MetaOp::unlink, nbr_of_blobs, path + "/meta" + extension);
+        print_ops(secs, "meta_unlink", nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 30) != t.end())
+    {
+        start_test("read_pread");
+        secs = read_pread(blob, nbr_of_blobs, path + "/write_c_style_io" + extension);
+        print_result(secs, "read_pread", blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 31) != t.end())
+    {
+        start_test("scan_rocks");
+        secs = scan_rocks(blob, nbr_of_blobs, path + "/rocksdb");
+        print_result(secs, "scan_rocks", blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 32) != t.end())
+    {
+        for (auto chunk_kb : rocks_chunk_kbs)
+        {
+            auto const msg("write_rocks_chunked_" + to_string(chunk_kb) + "KB");
+            auto const name(path + "/rocksdb_chunked_" + to_string(chunk_kb));
+            start_test(msg);
+            secs = write_rocks_chunked(blob, nbr_of_blobs, name, chunk_kb * 1024);
+            print_result(secs, msg, blob.size(), nbr_of_blobs);
+            print_amplification(msg, allocated_bytes(name), blob.size(), nbr_of_blobs);
+        }
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 33) != t.end())
+    {
+        for (auto chunk_kb : rocks_chunk_kbs)
+        {
+            auto const msg("read_rocks_chunked_" + to_string(chunk_kb) + "KB");
+            start_test(msg);
+            secs = read_rocks_chunked(blob, nbr_of_blobs, path + "/rocksdb_chunked_" + to_string(chunk_kb), chunk_kb * 1024);
+            print_result(secs, msg, blob.size(), nbr_of_blobs);
+        }
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 34) != t.end())
+    {
+        start_test("write_dedup");
+        auto const name(path + "/dedup" + extension);
+        secs = write_dedup(blob, nbr_of_blobs, name);
+        print_result(secs, "write_dedup", blob.size(), nbr_of_blobs);
+        print_amplification("write_dedup", allocated_bytes(name + "pack") + allocated_bytes(name + "manifest")
+            + allocated_bytes(name + "rocks"), blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 35) != t.end())
+    {
+        start_test("read_dedup");
+        secs = read_dedup(blob, nbr_of_blobs, path + "/dedup" + extension);
+        print_result(secs, "read_dedup", blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 36) != t.end())
+    {
+        start_test("seq_write_vectored");
+        secs = seq_write_vectored(blob.size(), nbr_of_blobs, path + "/seq_write_vectored" + extension);
+        print_result(secs, "seq_write_vectored", blob.size(), nbr_of_blobs);
+        print_extents(path + "/seq_write_vectored" + extension, "", nbr_of_blobs, "seq_write_vectored");
+        print_amplification("seq_write_vectored", blobs_footprint(path + "/seq_write_vectored" + extension, "", nbr_of_blobs), blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 37) != t.end())
+    {
+        start_test("seq_read_vectored");
+        secs = seq_read_vectored(blob.size(), nbr_of_blobs, path + "/seq_write_vectored" + extension);
+        print_result(secs, "seq_read_vectored", blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 38) != t.end())
+    {
+        start_test("write_hdf5_store");
+        secs = write_hdf5_store(blob, nbr_of_blobs, path + "/write_hdf5_store" + extension);
+        print_result(secs, "write_hdf5_store", blob.size(), nbr_of_blobs);
+        print_amplification("write_hdf5_store", allocated_bytes(path + "/write_hdf5_store" + extension + ".hdf5"), blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 39) != t.end())
+    {
+        start_test("read_hdf5_store");
+        secs = read_hdf5_store(blob, nbr_of_blobs, path + "/write_hdf5_store" + extension);
+        print_result(secs, "read_hdf5_store", blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 40) != t.end())
+    {
+        auto const msg("read_cached_" + cache_tuning.backend);
+        start_test(msg);
+        secs = read_cached(blob, nbr_of_blobs, blob_source(cache_tuning.backend, path, extension));
+        print_result(secs, msg, blob.size(), last_cached_requests);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 41) != t.end())
+    {
+        auto const msg("read_prefetched_" + prefetch_tuning.backend);
+        start_test(msg);
+        secs = read_prefetched(blob, nbr_of_blobs, blob_source(prefetch_tuning.backend, path, extension));
+        print_result(secs, msg, blob.size(), nbr_of_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 42) != t.end())
+    {
+        auto const source(blob_source(args::get(numaBackend), path, extension));
+        for (auto cpu_node(0); cpu_node != numa_nodes(); ++cpu_node)
+        {
+            for (auto mem_node(0); mem_node != numa_nodes(); ++mem_node)
+            {
+                auto const msg("read_numa_" + args::get(numaBackend) + "_cpu" + to_string(cpu_node) + "_mem" + to_string(mem_node));
+                start_test(msg);
+                secs = read_numa(blob, nbr_of_blobs, source, cpu_node, mem_node);
+                print_result(secs, msg, blob.size(), nbr_of_blobs);
+            }
+        }
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 43) != t.end())
+    {
+        auto const msg("ingest_" + ingest_tuning.mode);
+        auto const name(path + "/" + msg + extension);
+        auto const suffix(ingest_tuning.mode == "mio" ? ".mio" : ingest_tuning.mode == "hdf5" ? ".hdf5" : "");
+        start_test(msg);
+        secs = ingest(blob, nbr_of_blobs, name);
+        print_result(secs, msg, blob.size(), nbr_of_blobs);
+        print_amplification(msg, ingest_tuning.mode == "rocks" ? allocated_bytes(name)
+            : blobs_footprint(name, suffix, nbr_of_blobs), blob.size(), nbr_of_blobs);
+    }
+
+    if (soak_tuning.duration > 0.0 && (t.empty() || find(t.begin(), t.end(), 44) != t.end()))
+    {
+        // Writes the same blobs as the backend's write test, so soak_read
+        // and the other tests that read a backend find them there
+        auto const msg("soak_write_" + soak_tuning.backend);
+        start_test(msg);
+        secs = soak(blob, nbr_of_blobs, blob_sink(soak_tuning.backend, backend_file_name(soak_tuning.backend, path, extension)), BlobSource(), msg);
+        print_result(secs, msg, blob.size(), last_soak_blobs);
+    }
+
+    if (soak_tuning.duration > 0.0 && (t.empty() || find(t.begin(), t.end(), 45) != t.end()))
+    {
+        auto const msg("soak_read_" + soak_tuning.backend);
+        start_test(msg);
+        secs = soak(blob, nbr_of_blobs, BlobSink(), blob_source(soak_tuning.backend, path, extension), msg);
+        print_result(secs, msg, blob.size(), last_soak_blobs);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 46) != t.end())
+    {
+        for (auto batch_kb : log_batch_kbs)
+        {
+            auto const msg("write_log_" + to_string(batch_kb) + "KB");
+            start_test(msg);
+            secs = write_log(log_tuning.records, path + "/" + msg + extension + ".log", batch_kb * 1024);
+            print_ops(secs, msg, log_tuning.records);
+        }
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 47) != t.end())
+    {
+        BenchmarkRecords::for_each([&](auto type)
+        {
+            using Record = typename decltype(type)::type;
+            auto const msg("seq_write_records_" + string(Record::name));
+            start_test(msg);
+            secs = seq_write_records<Record>(blob.size(), nbr_of_blobs, path + "/" + msg + extension);
+            print_result(secs, msg, blob.size(), nbr_of_blobs);
+            print_records<Record>(secs, msg, blob.size(), nbr_of_blobs);
+        });
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 48) != t.end())
+    {
+        BenchmarkRecords::for_each([&](auto type)
+        {
+            using Record = typename decltype(type)::type;
+            auto const msg("seq_read_records_" + string(Record::name));
+            start_test(msg);
+            secs = seq_read_records<Record>(blob.size(), nbr_of_blobs, path + "/seq_write_records_" + Record::name + extension);
+            print_result(secs, msg, blob.size(), nbr_of_blobs);
+            print_records<Record>(secs, msg, blob.size(), nbr_of_blobs);
+        });
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 49) != t.end())
+    {
+        for (auto budget_mb : mem_budget_mbs)
+        {
+            set_mem_budget(budget_mb * 1048576, hdf5_unbudgeted);
+            auto const prefix("mem_budget_" + to_string(budget_mb) + "MB_");
+
+            start_test(prefix + "write_rocks");
+            secs = write_rocks(blob, nbr_of_blobs, path + "/" + prefix + "rocksdb");
+            print_result(secs, prefix + "write_rocks", blob.size(), nbr_of_blobs);
+
+            start_test(prefix + "read_rocks");
+            secs = read_rocks(blob, nbr_of_blobs, path + "/" + prefix + "rocksdb");
+            print_result(secs, prefix + "read_rocks", blob.size(), nbr_of_blobs);
+
+            start_test(prefix + "write_hdf5_store");
+            secs = write_hdf5_store(blob, nbr_of_blobs, path + "/" + prefix + "hdf5_store" + extension);
+            print_result(secs, prefix + "write_hdf5_store", blob.size(), nbr_of_blobs);
+
+            start_test(prefix + "read_hdf5_store");
+            secs = read_hdf5_store(blob, nbr_of_blobs, path + "/" + prefix + "hdf5_store" + extension);
+            print_result(secs, prefix + "read_hdf5_store", blob.size(), nbr_of_blobs);
+
+            start_test(prefix + "write_tiledb");
+            secs = write_tiledb(blob, nbr_of_blobs, path + "/" + prefix + "tiledb" + extension);
+            print_result(secs, prefix + "write_tiledb", blob.size(), nbr_of_blobs);
+
+            start_test(prefix + "read_tiledb");
+            secs = read_tiledb(blob, nbr_of_blobs, path + "/" + prefix + "tiledb" + extension);
+            print_result(secs, prefix + "read_tiledb", blob.size(), nbr_of_blobs);
+        }
+        set_mem_budget(size_t(max(0, args::get(memBudget))) * 1048576, hdf5_unbudgeted);
+    }
+
+    if (t.empty() || find(t.begin(), t.end(), 50) != t.end())
+    {
+        for (auto const& backend : update_backends)
+        {
+            auto const msg("update_" + backend);
+            start_test(msg);
+            secs = update_blobs(blob, nbr_of_blobs, backend, path + "/" + msg + extension, msg);
+            print_ops(secs, msg, update_tuning.updates > 0 ? update_tuning.updates : 10 * nbr_of_blobs);
+        }
+    }
+
     timer.stop();
     cout << endl;
 
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <filesystem>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+
+// Bytes allocated on disk for a file, or for everything below a directory.
+// Sparse and preallocated files are counted by their blocks, not their size.
+inline uint64_t allocated_bytes(std::string const& path)
+{
+    namespace fs = std::filesystem;
+
+    auto file_bytes = [](fs::path const& p) -> uint64_t
+    {
+#ifdef __linux__
+        struct stat st;
+        return ::lstat(p.c_str(), &st) == 0 ? uint64_t(st.st_blocks) * 512 : 0;
+#else
+        std::error_code error;
+        auto size = fs::file_size(p, error);
+        return error ? 0 : size;
+#endif
+    };
+
+    std::error_code error;
+    if (!fs::is_directory(path, error))
+        return fs::exists(path, error) ? file_bytes(path) : 0;
+
+    uint64_t total(0);
+    for (fs::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->is_regular_file(error))
+            total += file_bytes(it->path());
+    }
+    return total;
+}
+
+// Bytes written to the block device that holds a path, from /proc/diskstats.
+// Only available on Linux and when the path is on a real block device.
+class DeviceStats
+{
+public:
+    explicit DeviceStats(std::string const& path)
+    {
+#ifdef __linux__
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0)
+        {
+            m_major = major(st.st_dev);
+            m_minor = minor(st.st_dev);
+            std::string line;
+            m_valid = find_line(line);
+            if (m_valid)
+            {
+                std::istringstream is(line);
+                is >> m_major >> m_minor >> m_name;
+            }
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    bool valid() const { return m_valid; }
+    std::string const& name() const { return m_name; }
+
+    uint64_t bytes_written() const
+    {
+        std::string line;
+        if (!m_valid || !find_line(line))
+            return 0;
+
+        // major minor name reads merged sectors ms writes merged sectors ...
+        std::istringstream is(line);
+        unsigned dev_major, dev_minor;
+        std::string name;
+        uint64_t field[7]{};
+        is >> dev_major >> dev_minor >> name;
+        for (auto& f : field)
+            is >> f;
+        return field[6] * 512;
+    }
+
+private:
+    // The /proc/diskstats line of the device
+    bool find_line(std::string& result) const
+    {
+        std::ifstream diskstats("/proc/diskstats");
+        std::string line;
+        while (std::getline(diskstats, line))
+        {
+            std::istringstream is(line);
+            unsigned dev_major, dev_minor;
+            if (is >> dev_major >> dev_minor && dev_major == m_major && dev_minor == m_minor)
+            {
+                result = line;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    unsigned m_major{ 0 };
+    unsigned m_minor{ 0 };
+    std::string m_name;
+    bool m_valid{ false };
+};
+
+// Push all dirty pages out so the device counters include the writeback of a test
+inline void flush_file_systems()
+{
+#ifdef __linux__
+    ::sync();
+#endif
+}
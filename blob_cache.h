@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+// Frequency sketch of TinyLFU (Einziger et al.): a count-min sketch of 4 bit
+// counters that are all halved after 10 * width increments, so blobs that
+// were popular long ago fade out.
+class FrequencySketch
+{
+public:
+    explicit FrequencySketch(size_t width = 4096)
+        : m_width(round_up(width)), m_counters(depth * m_width), m_sample_size(10 * m_width)
+    {
+    }
+
+    void add(uint64_t key)
+    {
+        for (auto row(0); row != depth; ++row)
+        {
+            auto& counter(m_counters[index(row, key)]);
+            if (counter < 15)
+                ++counter;
+        }
+        if (++m_added == m_sample_size)
+        {
+            for (auto& counter : m_counters)
+                counter >>= 1;
+            m_added /= 2;
+        }
+    }
+
+    int estimate(uint64_t key) const
+    {
+        int result(15);
+        for (auto row(0); row != depth; ++row)
+            result = std::min<int>(result, m_counters[index(row, key)]);
+        return result;
+    }
+
+private:
+    static int const depth = 4;
+
+    static size_t round_up(size_t width)
+    {
+        size_t result(64);
+        while (result < width)
+            result <<= 1;
+        return result;
+    }
+
+    size_t index(int row, uint64_t key) const
+    {
+        // splitmix64 finalizer with a different seed per row
+        uint64_t z(key + (row + 1) * 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+        return row * m_width + (z & (m_width - 1));
+    }
+
+    size_t m_width;
+    std::vector<uint8_t> m_counters;
+    size_t m_sample_size;
+    size_t m_added{ 0 };
+};
+
+struct BlobCacheStats
+{
+    uint64_t hits{ 0 };
+    uint64_t misses{ 0 };
+    uint64_t inserts{ 0 };
+    uint64_t rejected{ 0 };  // Not admitted by TinyLFU or larger than a shard
+    uint64_t evictions{ 0 };
+    size_t entries{ 0 };
+    size_t bytes{ 0 };       // Bytes held, after compression
+    size_t blob_bytes{ 0 };  // Bytes of the blobs held
+
+    double hit_rate() const { return hits + misses != 0 ? double(hits) / (hits + misses) : 0.0; }
+};
+
+// Read cache of whole blobs with a byte budget. Keys are spread over shards
+// that each have their own lock, LRU list and budget. With admission a new
+// blob only replaces the LRU blob when TinyLFU has seen it more often, which
+// keeps one-off reads from flushing the hot blobs. Compressed entries trade
+// CPU for capacity, they are kept raw when zlib doesn't make them smaller.
+class BlobCache
+{
+public:
+    BlobCache(size_t capacity, int shards = 16, bool admission = true, bool compress = false)
+        : m_nbr_of_shards(std::max(1, shards)), m_shards(new Shard[m_nbr_of_shards]),
+        m_shard_capacity(capacity / m_nbr_of_shards), m_admission(admission), m_compress(compress)
+    {
+    }
+
+    // Copy a cached blob into blob, false on a miss
+    bool get(uint64_t key, std::vector<char>& blob)
+    {
+        auto& shard(shard_of(key));
+        std::shared_ptr<Entry const> entry;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.sketch.add(key);
+            auto found = shard.index.find(key);
+            if (found == shard.index.end())
+            {
+                ++shard.stats.misses;
+                return false;
+            }
+            shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+            entry = *found->second;
+            ++shard.stats.hits;
+        }
+
+        // Copied outside the lock, the entry stays alive even when evicted
+        blob.resize(entry->blob_size);
+        if (entry->compressed)
+        {
+            uLongf size(static_cast<uLongf>(blob.size()));
+            uncompress(reinterpret_cast<Bytef*>(blob.data()), &size,
+                reinterpret_cast<Bytef const*>(entry->data.data()), static_cast<uLong>(entry->data.size()));
+        }
+        else
+        {
+            memcpy(blob.data(), entry->data.data(), entry->data.size());
+        }
+        return true;
+    }
+
+    void put(uint64_t key, std::vector<char> const& blob)
+    {
+        auto entry(std::make_shared<Entry>());
+        entry->key = key;
+        entry->blob_size = blob.size();
+        if (m_compress)
+        {
+            entry->data.resize(compressBound(static_cast<uLong>(blob.size())));
+            uLongf size(static_cast<uLongf>(entry->data.size()));
+            if (compress2(reinterpret_cast<Bytef*>(entry->data.data()), &size,
+                reinterpret_cast<Bytef const*>(blob.data()), static_cast<uLong>(blob.size()), Z_BEST_SPEED) == Z_OK
+                && size < blob.size())
+            {
+                entry->data.resize(size);
+                entry->data.shrink_to_fit();
+                entry->compressed = true;
+            }
+        }
+        if (!entry->compressed)
+            entry->data = blob;
+
+        auto const charge(entry->data.size());
+        auto& shard(shard_of(key));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.count(key) != 0)
+            return;
+        if (charge > m_shard_capacity)
+        {
+            ++shard.stats.rejected;
+            return;
+        }
+        if (m_admission && shard.stats.bytes + charge > m_shard_capacity)
+        {
+            // Admit only when the new blob beats every blob it would evict,
+            // decided before the LRU is touched
+            auto const candidate(shard.sketch.estimate(key));
+            auto bytes(shard.stats.bytes);
+            for (auto victim(shard.lru.rbegin()); bytes + charge > m_shard_capacity; ++victim)
+            {
+                if (candidate <= shard.sketch.estimate((*victim)->key))
+                {
+                    ++shard.stats.rejected;
+                    return;
+                }
+                bytes -= (*victim)->data.size();
+            }
+        }
+        while (shard.stats.bytes + charge > m_shard_capacity)
+        {
+            auto const& victim(shard.lru.back());
+            shard.stats.bytes -= victim->data.size();
+            shard.stats.blob_bytes -= victim->blob_size;
+            shard.index.erase(victim->key);
+            shard.lru.pop_back();
+            ++shard.stats.evictions;
+        }
+        shard.lru.push_front(entry);
+        shard.index[key] = shard.lru.begin();
+        shard.stats.bytes += charge;
+        shard.stats.blob_bytes += entry->blob_size;
+        ++shard.stats.inserts;
+    }
+
+    BlobCacheStats stats() const
+    {
+        BlobCacheStats total;
+        for (auto s(0); s != m_nbr_of_shards; ++s)
+        {
+            auto& shard(m_shards[s]);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total.hits += shard.stats.hits;
+            total.misses += shard.stats.misses;
+            total.inserts += shard.stats.inserts;
+            total.rejected += shard.stats.rejected;
+            total.evictions += shard.stats.evictions;
+            total.entries += shard.index.size();
+            total.bytes += shard.stats.bytes;
+            total.blob_bytes += shard.stats.blob_bytes;
+        }
+        return total;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t key{ 0 };
+        size_t blob_size{ 0 };
+        bool compressed{ false };
+        std::vector<char> data;
+    };
+
+    using Lru = std::list<std::shared_ptr<Entry const>>;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        Lru lru;
+        std::unordered_map<uint64_t, Lru::iterator> index;
+        FrequencySketch sketch;
+        BlobCacheStats stats;
+    };
+
+    Shard& shard_of(uint64_t key) const
+    {
+        return m_shards[(key * 0x9e3779b97f4a7c15ull >> 32) % m_nbr_of_shards];
+    }
+
+    int m_nbr_of_shards;
+    std::unique_ptr<Shard[]> m_shards;
+    size_t m_shard_capacity;
+    bool m_admission;
+    bool m_compress;
+};
+
+// Blob indices in [0, n) where index k is drawn with a probability
+// proportional to 1 / (k + 1)^skew. A skew of 0 is uniform.
+class ZipfGenerator
+{
+public:
+    ZipfGenerator(size_t n, double skew)
+        : m_cdf(n)
+    {
+        double sum(0.0);
+        for (size_t k(0); k != n; ++k)
+        {
+            sum += 1.0 / std::pow(double(k + 1), skew);
+            m_cdf[k] = sum;
+        }
+        for (auto& p : m_cdf)
+            p /= sum;
+    }
+
+    template<class Engine>
+    size_t operator()(Engine& engine) const
+    {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        auto const k(std::lower_bound(m_cdf.begin(), m_cdf.end(), uniform(engine)) - m_cdf.begin());
+        return std::min(static_cast<size_t>(k), m_cdf.size() - 1);
+    }
+
+private:
+    std::vector<double> m_cdf;
+};
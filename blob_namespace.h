@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <system_error>
+#include <unordered_set>
+#include <filesystem>
+
+// Maps blob i of a backend to a file name. Without sharding all blobs end up
+// flat next to each other as file_name + i. With sharding a hash of i picks
+// one sub directory on each level below the directory of file_name, every
+// directory having fanout sub directories, e.g. "dir/3f/a0/write_c_style_io17".
+class BlobNamespace
+{
+public:
+    BlobNamespace(int levels = 0, int fanout = 256) : m_levels(levels), m_fanout(fanout)
+    {
+        m_width = 1;
+        for (auto f(fanout - 1); f > 0xf; f >>= 4)
+            ++m_width;
+    }
+
+    int levels() const { return m_levels; }
+    int fanout() const { return m_fanout; }
+
+    std::string name(std::string const& file_name, size_t i, std::string const& suffix = "") const
+    {
+        if (m_levels == 0)
+            return file_name + std::to_string(i) + suffix;
+
+        auto pos = file_name.find_last_of("/\\");
+        auto dir = pos == std::string::npos ? std::string(".") : file_name.substr(0, pos);
+        auto base = pos == std::string::npos ? file_name : file_name.substr(pos + 1);
+        return dir + shard(mix(i)) + "/" + base + std::to_string(i) + suffix;
+    }
+
+    // Create the shard directories of blobs [0, nbr_of_blobs) below dir, done
+    // once before a run so the writers never have to check for missing
+    // directories. Only the leaves that blobs land in are created, there may
+    // be far more of them than blobs.
+    void create_dirs(std::string const& dir, size_t nbr_of_blobs, std::error_code& error) const
+    {
+        std::unordered_set<std::string> created;
+        for (size_t i(0); i != nbr_of_blobs && !error; ++i)
+        {
+            auto leaf(shard(mix(i)));
+            if (created.insert(leaf).second)
+                std::filesystem::create_directories(dir + leaf, error);
+        }
+    }
+
+private:
+    // splitmix64 finalizer, spreads consecutive blob ids over all shards
+    static uint64_t mix(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    std::string shard(uint64_t hash) const
+    {
+        std::string path;
+        char part[20];
+        for (auto l(0); l != m_levels; ++l)
+        {
+            snprintf(part, sizeof(part), "/%0*x", m_width, static_cast<unsigned>(hash % m_fanout));
+            path += part;
+            hash /= m_fanout;
+        }
+        return path;
+    }
+
+    int m_levels;
+    int m_fanout;
+    int m_width;
+};
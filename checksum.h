@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_X64
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// CRC32C (Castagnoli), using the SSE4.2 crc32 instruction when the CPU has it
+namespace crc32c_detail
+{
+    inline std::array<uint32_t, 256> const& table()
+    {
+        static std::array<uint32_t, 256> const t = []
+        {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i(0); i != 256; ++i)
+            {
+                uint32_t crc(i);
+                for (auto bit(0); bit != 8; ++bit)
+                    crc = (crc >> 1) ^ (crc & 1 ? 0x82f63b78u : 0u);
+                t[i] = crc;
+            }
+            return t;
+        }();
+        return t;
+    }
+
+    inline uint32_t software(uint32_t crc, unsigned char const* p, size_t size)
+    {
+        auto const& t(table());
+        while (size-- != 0)
+            crc = t[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        return crc;
+    }
+
+#ifdef CRC32C_X64
+#ifdef __GNUC__
+    __attribute__((target("sse4.2")))
+#endif
+    inline uint32_t hardware(uint32_t crc, unsigned char const* p, size_t size)
+    {
+        uint64_t crc64(crc);
+        for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+        crc = static_cast<uint32_t>(crc64);
+        for (; size != 0; --size)
+            crc = _mm_crc32_u8(crc, *p++);
+        return crc;
+    }
+#endif
+}
+
+inline bool crc32c_hardware()
+{
+#ifdef CRC32C_X64
+#ifdef _MSC_VER
+    static bool const hw = []
+    {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+    }();
+#else
+    static bool const hw = __builtin_cpu_supports("sse4.2");
+#endif
+    return hw;
+#else
+    return false;
+#endif
+}
+
+inline uint32_t crc32c(char const* data, size_t size, uint32_t crc = 0)
+{
+    auto p = reinterpret_cast<unsigned char const*>(data);
+    crc = ~crc;
+#ifdef CRC32C_X64
+    if (crc32c_hardware())
+        return ~crc32c_detail::hardware(crc, p, size);
+#endif
+    return ~crc32c_detail::software(crc, p, size);
+}
+
+// The checksums of all blobs of a test, stored in a file next to the data
+inline void save_checksum_file(std::string const& name, std::vector<uint32_t> const& sums)
+{
+    std::ofstream file(name, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<char const*>(sums.data()), sums.size() * sizeof(uint32_t));
+}
+
+inline std::vector<uint32_t> load_checksum_file(std::string const& name)
+{
+    std::ifstream file(name, std::ios::binary | std::ios::ate);
+    std::vector<uint32_t> sums(file ? static_cast<size_t>(file.tellg()) / sizeof(uint32_t) : 0);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(sums.data()), sums.size() * sizeof(uint32_t));
+    return sums;
+}
@@ -0,0 +1,422 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// Page faults of the whole process. Windows doesn't tell minor and major
+// faults apart, all of them are counted as minor there.
+struct PageFaults
+{
+    long minor{ 0 };
+    long major{ 0 };
+
+    PageFaults operator-(PageFaults const& other) const
+    {
+        return PageFaults{ minor - other.minor, major - other.major };
+    }
+};
+
+inline PageFaults page_faults()
+{
+    PageFaults faults;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+        faults.minor = counters.PageFaultCount;
+#else
+    rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        faults.minor = usage.ru_minflt;
+        faults.major = usage.ru_majflt;
+    }
+#endif
+    return faults;
+}
+
+// I/O done by the process, as in /proc/self/io. The bytes that reached the
+// device are only known on Linux.
+struct IoCounters
+{
+    uint64_t rchar{ 0 };       // Bytes passed to read-like calls
+    uint64_t wchar{ 0 };       // Bytes passed to write-like calls
+    uint64_t syscr{ 0 };       // Number of read-like calls
+    uint64_t syscw{ 0 };       // Number of write-like calls
+    uint64_t read_bytes{ 0 };  // Bytes fetched from the device
+    uint64_t write_bytes{ 0 }; // Bytes sent to the device
+
+    IoCounters operator-(IoCounters const& other) const
+    {
+        return IoCounters{ rchar - other.rchar, wchar - other.wchar, syscr - other.syscr,
+            syscw - other.syscw, read_bytes - other.read_bytes, write_bytes - other.write_bytes };
+    }
+};
+
+// file is the /proc file to read, /proc/thread-self/io gives the calling thread
+inline IoCounters io_counters(char const* file = "/proc/self/io")
+{
+    IoCounters io;
+#ifdef _WIN32
+    IO_COUNTERS counters;
+    if (::GetProcessIoCounters(::GetCurrentProcess(), &counters))
+    {
+        io.rchar = counters.ReadTransferCount;
+        io.wchar = counters.WriteTransferCount;
+        io.syscr = counters.ReadOperationCount;
+        io.syscw = counters.WriteOperationCount;
+    }
+#else
+    std::ifstream proc(file);
+    std::string key;
+    uint64_t value;
+    while (proc >> key >> value)
+    {
+        if (key == "rchar:")
+            io.rchar = value;
+        else if (key == "wchar:")
+            io.wchar = value;
+        else if (key == "syscr:")
+            io.syscr = value;
+        else if (key == "syscw:")
+            io.syscw = value;
+        else if (key == "read_bytes:")
+            io.read_bytes = value;
+        else if (key == "write_bytes:")
+            io.write_bytes = value;
+    }
+#endif
+    return io;
+}
+
+// User plus system CPU time of all threads in the process
+inline double cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!::GetProcessTimes(::GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    auto ticks = [](FILETIME const& ft) { return (uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+    rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+// Resident set size of the process and its peak, in bytes. The peak can
+// only be reset on Linux, elsewhere it is the peak of the whole process.
+struct ResidentMemory
+{
+    uint64_t current{ 0 };
+    uint64_t peak{ 0 };
+};
+
+inline ResidentMemory resident_memory()
+{
+    ResidentMemory memory;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        memory.current = counters.WorkingSetSize;
+        memory.peak = counters.PeakWorkingSetSize;
+    }
+#elif defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    uint64_t kb;
+    while (status >> key)
+    {
+        if (key == "VmRSS:" && status >> kb)
+            memory.current = kb * 1024;
+        else if (key == "VmHWM:" && status >> kb)
+            memory.peak = kb * 1024;
+        status.ignore(256, '\n');
+    }
+#else
+    rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        memory.peak = usage.ru_maxrss;
+#else
+        memory.peak = uint64_t(usage.ru_maxrss) * 1024;
+#endif
+        memory.current = memory.peak;
+    }
+#endif
+    return memory;
+}
+
+// Make the peak resident set size start over at the current size
+inline bool reset_peak_resident()
+{
+#ifdef __linux__
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return clear_refs.good();
+#else
+    return false;
+#endif
+}
+
+// CPU time, page faults and I/O of the calling thread, only known on Linux
+struct ThreadCost
+{
+    double cpu_secs{ 0.0 };
+    PageFaults faults;
+    IoCounters io;
+};
+
+inline ThreadCost thread_cost()
+{
+    ThreadCost cost;
+#ifdef __linux__
+    rusage usage;
+    if (::getrusage(RUSAGE_THREAD, &usage) == 0)
+    {
+        cost.cpu_secs = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+        cost.faults.minor = usage.ru_minflt;
+        cost.faults.major = usage.ru_majflt;
+    }
+    cost.io = io_counters("/proc/thread-self/io");
+#endif
+    return cost;
+}
+
+struct RssStats
+{
+    double average{ 0.0 }; // Bytes
+    uint64_t max{ 0 };     // Largest sample
+    uint64_t peak{ 0 };    // Peak as the OS saw it where it can be reset, catches what the samples miss
+    int samples{ 0 };
+    ThreadCost sampler;    // What the sampling cost, to take out of the process counters
+};
+
+// Samples the resident set size from start() until stop(), every interval
+// or only at both ends when interval is 0. All the sampling happens on its
+// own thread so its cost can be measured; counters that bracket start() and
+// stop() can subtract it, all but the read of the thread's own counters.
+class RssSampler
+{
+public:
+    RssSampler() = default;
+    ~RssSampler() { stop(); }
+
+    RssSampler(RssSampler const&) = delete;
+    RssSampler& operator=(RssSampler const&) = delete;
+
+    void start(std::chrono::milliseconds interval)
+    {
+        stop();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stats = RssStats();
+        m_sum = 0.0;
+        m_stop = false;
+        m_started = false;
+        m_thread = std::thread(&RssSampler::run, this, interval);
+        m_changed.wait(lock, [&] { return m_started; });
+    }
+
+    RssStats stop()
+    {
+        if (m_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_changed.notify_all();
+            m_thread.join();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+    void run(std::chrono::milliseconds interval)
+    {
+        auto const peak_reset(reset_peak_resident());
+        auto memory(resident_memory());
+        std::unique_lock<std::mutex> lock(m_mutex);
+        add(memory);
+        m_started = true;
+        m_changed.notify_all();
+
+        auto const stopped = [&] { return m_stop; };
+        while (interval.count() > 0 && !m_changed.wait_for(lock, interval, stopped))
+        {
+            lock.unlock();
+            memory = resident_memory();
+            lock.lock();
+            add(memory);
+        }
+        m_changed.wait(lock, stopped);
+
+        lock.unlock();
+        memory = resident_memory();
+        lock.lock();
+        add(memory);
+        m_stats.peak = peak_reset ? std::max(m_stats.max, memory.peak) : m_stats.max;
+        m_stats.sampler = thread_cost();
+    }
+
+    void add(ResidentMemory const& memory)
+    {
+        m_sum += double(memory.current);
+        ++m_stats.samples;
+        m_stats.average = m_sum / m_stats.samples;
+        m_stats.max = std::max(m_stats.max, memory.current);
+    }
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_stop{ false };
+    bool m_started{ false };
+    double m_sum{ 0.0 };
+    RssStats m_stats;
+};
+
+enum PerfCounter
+{
+    perf_cycles,
+    perf_instructions,
+    perf_cache_misses,
+    perf_context_switches,
+    perf_page_faults,
+    nbr_of_perf_counters
+};
+
+struct CounterSample
+{
+    double cpu_secs{ 0.0 };
+    PageFaults faults;
+    IoCounters io;
+    std::array<double, nbr_of_perf_counters> perf{};
+
+    CounterSample operator-(CounterSample const& other) const
+    {
+        CounterSample diff;
+        diff.cpu_secs = cpu_secs - other.cpu_secs;
+        diff.faults = faults - other.faults;
+        diff.io = io - other.io;
+        for (auto c(0); c != nbr_of_perf_counters; ++c)
+            diff.perf[c] = perf[c] - other.perf[c];
+        return diff;
+    }
+};
+
+// Collects OS and hardware counters around a test, start() when the test
+// begins and stop() when it ends. The counters cover everything the process
+// does in between, also the work a test keeps out of its Timer.
+// The perf_event_open counters follow every thread created after the
+// instrumentation, and are missing when the kernel doesn't allow them
+// (see /proc/sys/kernel/perf_event_paranoid).
+class Instrumentation
+{
+public:
+    Instrumentation()
+    {
+        m_fds.fill(-1);
+#ifdef __linux__
+        m_fds[perf_cycles] = open_perf(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        m_fds[perf_instructions] = open_perf(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        m_fds[perf_cache_misses] = open_perf(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        m_fds[perf_context_switches] = open_perf(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+        m_fds[perf_page_faults] = open_perf(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+    }
+
+    ~Instrumentation()
+    {
+#ifdef __linux__
+        for (auto fd : m_fds)
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+#endif
+    }
+
+    Instrumentation(Instrumentation const&) = delete;
+    Instrumentation& operator=(Instrumentation const&) = delete;
+
+    bool has_perf(PerfCounter counter) const { return m_fds[counter] >= 0; }
+
+    void start() { m_start = sample(); }
+
+    CounterSample stop() const { return sample() - m_start; }
+
+private:
+#ifdef __linux__
+    static int open_perf(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.inherit = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        auto fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd < 0)
+        {
+            // Unprivileged users may still count user space
+            attr.exclude_kernel = 1;
+            fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+        return static_cast<int>(fd);
+    }
+
+    // Counter value scaled up for the time the counter was multiplexed out
+    static double read_perf(int fd)
+    {
+        uint64_t values[3]{};
+        if (fd < 0 || ::read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0)
+            return 0.0;
+        return double(values[0]) * values[1] / values[2];
+    }
+#endif
+
+    CounterSample sample() const
+    {
+        CounterSample s;
+        s.cpu_secs = cpu_seconds();
+        s.faults = page_faults();
+        s.io = io_counters();
+#ifdef __linux__
+        for (auto c(0); c != nbr_of_perf_counters; ++c)
+            s.perf[c] = read_perf(m_fds[c]);
+#endif
+        return s;
+    }
+
+    std::array<int, nbr_of_perf_counters> m_fds;
+    CounterSample m_start;
+};
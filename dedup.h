@@ -0,0 +1,240 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Content defined chunking with FastCDC (Xia et al. 2016): a Gear rolling
+// hash with normalized chunking. Cut points depend only on the bytes just
+// before them, so an edit in a blob only changes the chunks around it.
+class FastCdc
+{
+public:
+    explicit FastCdc(size_t avg_size = 8192)
+        : m_min(avg_size / 4), m_avg(avg_size), m_max(avg_size * 8)
+    {
+        auto bits(0);
+        while ((size_t(1) << (bits + 1)) <= avg_size)
+            ++bits;
+        // A harder mask before the average size and an easier one after it
+        // keeps most chunks close to the average
+        m_mask_s = mask(bits + 1);
+        m_mask_l = mask(bits - 1);
+    }
+
+    // Length of the chunk that starts at data
+    size_t cut(char const* data, size_t size) const
+    {
+        if (size <= m_min)
+            return size;
+
+        auto const p = reinterpret_cast<unsigned char const*>(data);
+        auto const& g(gear());
+        auto const end(size < m_max ? size : m_max);
+        auto const normal(end < m_avg ? end : m_avg);
+        uint64_t hash(0);
+        size_t i(m_min);
+        for (; i < normal; ++i)
+        {
+            hash = (hash << 1) + g[p[i]];
+            if ((hash & m_mask_s) == 0)
+                return i + 1;
+        }
+        for (; i < end; ++i)
+        {
+            hash = (hash << 1) + g[p[i]];
+            if ((hash & m_mask_l) == 0)
+                return i + 1;
+        }
+        return end;
+    }
+
+    // Call emit(offset, length) for every chunk of data
+    template<class F>
+    void split(char const* data, size_t size, F&& emit) const
+    {
+        for (size_t offset(0); offset < size;)
+        {
+            auto const length(cut(data + offset, size - offset));
+            emit(offset, length);
+            offset += length;
+        }
+    }
+
+private:
+    // The high bits of the Gear hash depend on the most bytes
+    static uint64_t mask(int bits)
+    {
+        return bits <= 0 ? 0 : ~uint64_t(0) << (64 - bits);
+    }
+
+    static std::array<uint64_t, 256> const& gear()
+    {
+        static std::array<uint64_t, 256> const table = []
+        {
+            std::array<uint64_t, 256> t{};
+            uint64_t x(0x2545f4914f6cdd1dull);
+            for (auto& v : t)
+            {
+                // splitmix64, a fixed table keeps cut points stable between runs
+                x += 0x9e3779b97f4a7c15ull;
+                uint64_t z(x);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                v = z ^ (z >> 31);
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    size_t m_min;
+    size_t m_avg;
+    size_t m_max;
+    uint64_t m_mask_s;
+    uint64_t m_mask_l;
+};
+
+// 128 bit chunk fingerprint, XXH64 with its four independent lanes so the
+// CPU can run them in parallel. The high half mixes the lanes differently.
+struct Fingerprint
+{
+    uint64_t lo;
+    uint64_t hi;
+
+    bool operator==(Fingerprint const& other) const { return lo == other.lo && hi == other.hi; }
+};
+
+struct FingerprintHash
+{
+    size_t operator()(Fingerprint const& f) const { return static_cast<size_t>(f.lo); }
+};
+
+namespace xxh64_detail
+{
+    uint64_t const p1 = 11400714785074694791ull;
+    uint64_t const p2 = 14029467366897019727ull;
+    uint64_t const p3 = 1609587929392839161ull;
+    uint64_t const p4 = 9650029242287828579ull;
+    uint64_t const p5 = 2870177450012600261ull;
+
+    inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    inline uint64_t read64(unsigned char const* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+    inline uint32_t read32(unsigned char const* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+    inline uint64_t round(uint64_t acc, uint64_t input)
+    {
+        acc += input * p2;
+        acc = rotl(acc, 31);
+        return acc * p1;
+    }
+
+    inline uint64_t merge(uint64_t acc, uint64_t val)
+    {
+        acc ^= round(0, val);
+        return acc * p1 + p4;
+    }
+
+    inline uint64_t avalanche(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= p2;
+        h ^= h >> 29;
+        h *= p3;
+        return h ^ (h >> 32);
+    }
+}
+
+inline Fingerprint fingerprint(char const* data, size_t size, uint64_t seed = 0)
+{
+    using namespace xxh64_detail;
+
+    auto p = reinterpret_cast<unsigned char const*>(data);
+    auto const end(p + size);
+    uint64_t h, alt;
+
+    if (size >= 32)
+    {
+        uint64_t v1(seed + p1 + p2), v2(seed + p2), v3(seed), v4(seed - p1);
+        for (auto const limit(end - 32); p <= limit; p += 32)
+        {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+        alt = rotl(v1, 3) ^ rotl(v2, 11) ^ rotl(v3, 23) ^ rotl(v4, 37);
+    }
+    else
+    {
+        h = seed + p5;
+        alt = seed + p4;
+    }
+
+    h += size;
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * p1 + p4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= uint64_t(read32(p)) * p1;
+        h = rotl(h, 23) * p2 + p3;
+        p += 4;
+    }
+    for (; p != end; ++p)
+    {
+        h ^= *p * p5;
+        h = rotl(h, 11) * p1;
+    }
+
+    h = avalanche(h);
+    return Fingerprint{ h, avalanche(alt ^ (h * p5) ^ size) };
+}
+
+// Where a unique chunk lives in a pack file
+struct ChunkRef
+{
+    uint64_t offset;
+    uint32_t size;
+};
+
+// The chunk list of every blob, stored as a count followed by the refs
+inline void save_manifests(std::string const& name, std::vector<std::vector<ChunkRef>> const& manifests)
+{
+    std::ofstream file(name, std::ios::binary | std::ios::trunc);
+    for (auto const& manifest : manifests)
+    {
+        uint32_t const n(static_cast<uint32_t>(manifest.size()));
+        file.write(reinterpret_cast<char const*>(&n), sizeof(n));
+        for (auto const& ref : manifest)
+        {
+            file.write(reinterpret_cast<char const*>(&ref.offset), sizeof(ref.offset));
+            file.write(reinterpret_cast<char const*>(&ref.size), sizeof(ref.size));
+        }
+    }
+}
+
+inline std::vector<std::vector<ChunkRef>> load_manifests(std::string const& name)
+{
+    std::vector<std::vector<ChunkRef>> manifests;
+    std::ifstream file(name, std::ios::binary);
+    uint32_t n;
+    while (file.read(reinterpret_cast<char*>(&n), sizeof(n)))
+    {
+        std::vector<ChunkRef> manifest(n);
+        for (auto& ref : manifest)
+        {
+            file.read(reinterpret_cast<char*>(&ref.offset), sizeof(ref.offset));
+            file.read(reinterpret_cast<char*>(&ref.size), sizeof(ref.size));
+        }
+        manifests.push_back(std::move(manifest));
+    }
+    return manifests;
+}
@@ -1,21 +1,81 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <cereal/types/vector.hpp>
 
+// The records of the sequential tests. Their serialize functions are
+// constexpr so RecordSchema can derive the chunks of a record from them.
 struct Fake
 {
+    static constexpr char const* name = "fake";
+
     char d1[96];
     char d2[90];
     char d3[96];
     char d4[60];
 
     template<class Archive>
-    void serialize(Archive& archive)
+    constexpr void serialize(Archive& archive)
     {
         archive(d1,d2,d3,d4);
     }
 };
 
+// Market data trade, small numeric fields
+struct Trade
+{
+    static constexpr char const* name = "trade";
+
+    int64_t time_ns;
+    int64_t order_id;
+    double price;
+    double quantity;
+    int32_t instrument;
+    int32_t venue;
+    char flags[8];
+
+    template<class Archive>
+    constexpr void serialize(Archive& archive)
+    {
+        archive(time_ns, order_id, price, quantity, instrument, venue, flags);
+    }
+};
+
+// Sensor sample, a header and a vector of readings
+struct SensorSample
+{
+    static constexpr char const* name = "sensor";
+
+    uint64_t time_ns;
+    uint32_t sensor;
+    uint32_t status;
+    float values[64];
+
+    template<class Archive>
+    constexpr void serialize(Archive& archive)
+    {
+        archive(time_ns, sensor, status, values);
+    }
+};
+
+// Log line, mostly text
+struct LogLine
+{
+    static constexpr char const* name = "log_line";
+
+    int64_t time_ns;
+    uint32_t level;
+    uint32_t thread;
+    char source[56];
+    char text[440];
+
+    template<class Archive>
+    constexpr void serialize(Archive& archive)
+    {
+        archive(time_ns, level, thread, source, text);
+    }
+};
+
 struct FakeData
 {
     std::vector<Fake> fakes;
@@ -26,5 +86,3 @@ struct FakeData
         archive(fakes);
     }
 };
-
-
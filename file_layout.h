@@ -0,0 +1,167 @@
+#pragma once
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <system_error>
+#include <filesystem>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#endif
+
+// How a writer reserves space for a file before the data is written.
+enum class AllocPolicy
+{
+    none,            // Writer specific default, files grow as they are written
+    fallocate,       // fallocate(), allocates blocks and extends the file size
+    keep_size,       // fallocate(FALLOC_FL_KEEP_SIZE), allocates blocks beyond EOF
+    posix_fallocate, // posix_fallocate(), may be emulated by writing zeroes
+    truncate         // ftruncate() only, gives a sparse file
+};
+
+// False for a name that is not a policy
+inline bool parse_alloc_policy(std::string const& name, AllocPolicy& policy)
+{
+    if (name == "none")
+        policy = AllocPolicy::none;
+    else if (name == "fallocate")
+        policy = AllocPolicy::fallocate;
+    else if (name == "keep_size")
+        policy = AllocPolicy::keep_size;
+    else if (name == "posix_fallocate")
+        policy = AllocPolicy::posix_fallocate;
+    else if (name == "truncate")
+        policy = AllocPolicy::truncate;
+    else
+        return false;
+    return true;
+}
+
+inline char const* alloc_policy_name(AllocPolicy policy)
+{
+    switch (policy)
+    {
+    case AllocPolicy::fallocate: return "fallocate";
+    case AllocPolicy::keep_size: return "keep_size";
+    case AllocPolicy::posix_fallocate: return "posix_fallocate";
+    case AllocPolicy::truncate: return "truncate";
+    default: return "none";
+    }
+}
+
+#ifdef __linux__
+// Reserve size bytes in an open file. When set_size is true the file size is
+// always size afterwards, which the mmap writers need to map the whole blob.
+inline void preallocate(int fd, size_t size, AllocPolicy policy, bool set_size, std::error_code& error)
+{
+    int res(0);
+    switch (policy)
+    {
+    case AllocPolicy::fallocate:
+        res = ::fallocate(fd, 0, 0, size) == 0 ? 0 : errno;
+        break;
+    case AllocPolicy::keep_size:
+        res = ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size) == 0 ? 0 : errno;
+        break;
+    case AllocPolicy::posix_fallocate:
+        res = ::posix_fallocate(fd, 0, size);
+        break;
+    case AllocPolicy::truncate:
+        res = ::ftruncate(fd, size) == 0 ? 0 : errno;
+        break;
+    default:
+        break;
+    }
+
+    if (res == 0 && set_size && (policy == AllocPolicy::keep_size || policy == AllocPolicy::none))
+    {
+        res = ::ftruncate(fd, size) == 0 ? 0 : errno;
+    }
+
+    if (res != 0)
+        error.assign(res, std::generic_category());
+}
+#endif
+
+// Create or truncate name and reserve size bytes according to policy. The
+// writer must then open the file without truncating it again.
+inline void prepare_file(std::string const& name, size_t size, AllocPolicy policy, bool set_size, std::error_code& error)
+{
+#ifdef __linux__
+    int fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        error.assign(errno, std::generic_category());
+        return;
+    }
+    preallocate(fd, size, policy, set_size, error);
+    ::close(fd);
+#else
+    // Only plain resizing is available outside Linux
+    { std::ofstream(name, std::ios::binary | std::ios::trunc); }
+    if (policy != AllocPolicy::none || set_size)
+        std::filesystem::resize_file(name, size, error);
+#endif
+}
+
+// Number of extents the file system uses for name, -1 if unknown.
+inline int extent_count(std::string const& name)
+{
+#ifdef __linux__
+    int fd = ::open(name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    fiemap map;
+    memset(&map, 0, sizeof(map));
+    map.fm_start = 0;
+    map.fm_length = FIEMAP_MAX_OFFSET;
+    map.fm_flags = FIEMAP_FLAG_SYNC;
+    map.fm_extent_count = 0; // Only count the extents
+
+    int res = ::ioctl(fd, FS_IOC_FIEMAP, &map);
+    ::close(fd);
+    return res == 0 ? static_cast<int>(map.fm_mapped_extents) : -1;
+#else
+    return -1;
+#endif
+}
+
+// Buffer aligned for O_DIRECT transfers.
+struct AlignedBufferDeleter
+{
+    void operator()(char* p) const
+    {
+#ifdef _WIN32
+        ::_aligned_free(p);
+#else
+        ::free(p);
+#endif
+    }
+};
+using AlignedBuffer = std::unique_ptr<char[], AlignedBufferDeleter>;
+
+const size_t direct_io_alignment = 4096;
+
+inline size_t align_up(size_t size, size_t alignment = direct_io_alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+inline AlignedBuffer make_aligned_buffer(size_t size, size_t alignment = direct_io_alignment)
+{
+    void* p(nullptr);
+#ifdef _WIN32
+    p = ::_aligned_malloc(align_up(size, alignment), alignment);
+#else
+    if (::posix_memalign(&p, alignment, align_up(size, alignment)) != 0)
+        p = nullptr;
+#endif
+    return AlignedBuffer(static_cast<char*>(p));
+}
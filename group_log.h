@@ -0,0 +1,230 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+// Append-only log with group commit. Producers reserve space in the current
+// buffer with one atomic add and copy their record in without taking a
+// lock. A flusher thread seals the buffer, swaps in the other one so the
+// producers can go on, and writes the sealed buffer with one pwrite and one
+// fdatasync. A batch is whatever accumulated during the previous flush, at
+// most batch_size bytes, or what arrived within max_delay when nobody waits.
+class GroupCommitLog
+{
+public:
+    GroupCommitLog(int fd, size_t batch_size, std::chrono::microseconds max_delay)
+        : m_fd(fd), m_capacity(batch_size), m_delay(max_delay)
+    {
+        for (auto& buffer : m_buffers)
+            buffer.data.reset(new char[m_capacity]);
+        m_buffers[1].reserved = sealed;
+        m_current = &m_buffers[0];
+        m_flusher = std::thread(&GroupCommitLog::flush_loop, this);
+    }
+
+    ~GroupCommitLog() { stop(); }
+
+    GroupCommitLog(GroupCommitLog const&) = delete;
+    GroupCommitLog& operator=(GroupCommitLog const&) = delete;
+
+    // Copy a record of at most batch_size bytes into the log, returns the
+    // log offset just after it
+    uint64_t append(char const* data, size_t size)
+    {
+        for (;;)
+        {
+            auto buffer(m_current.load(std::memory_order_acquire));
+            auto const offset(buffer->reserved.fetch_add(size, std::memory_order_acq_rel));
+            if (offset + size <= m_capacity)
+            {
+                memcpy(buffer->data.get() + offset, data, size);
+                auto const lsn(buffer->base + offset + size);
+                buffer->written.fetch_add(size, std::memory_order_release);
+                if (offset + size == m_capacity)
+                    wake_flusher();
+                return lsn;
+            }
+            if (offset <= m_capacity)
+            {
+                // This record ends the buffer, it goes into the next one
+                buffer->limit.store(offset, std::memory_order_release);
+                wake_flusher();
+            }
+            // Wait for the flusher to swap in the other buffer. The buffer may
+            // already be recycled as the current one by then, with room again.
+            while (m_current.load(std::memory_order_acquire) == buffer
+                && buffer->reserved.load(std::memory_order_acquire) > m_capacity && !m_failed)
+                std::this_thread::yield();
+            if (m_failed)
+                return 0;
+        }
+    }
+
+    // Block until the log is on disk up to lsn, false when writing failed
+    bool wait_durable(uint64_t lsn)
+    {
+        if (m_durable.load(std::memory_order_acquire) >= lsn)
+            return true;
+        wake_flusher();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_durable_changed.wait(lock, [&] { return m_durable.load() >= lsn || m_failed; });
+        return !m_failed;
+    }
+
+    // Log offset up to which the log is on disk
+    uint64_t durable() const { return m_durable.load(std::memory_order_acquire); }
+
+    // Flush what is left and stop the flusher, no appends may follow
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_flush_wanted.notify_one();
+        if (m_flusher.joinable())
+            m_flusher.join();
+    }
+
+    // When a batch made the log durable up to an offset
+    struct Commit
+    {
+        uint64_t durable;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    // One commit per batch in log order, complete once stop() returned
+    std::vector<Commit> const& commits() const { return m_commits; }
+
+    size_t batches() const { return m_batches; }
+    std::error_code error() const { return m_error; }
+
+private:
+    static size_t const sealed = size_t(1) << 62;
+    static size_t const no_limit = ~size_t(0);
+
+    struct Buffer
+    {
+        std::unique_ptr<char[]> data;
+        std::atomic<size_t> reserved{ 0 };
+        std::atomic<size_t> written{ 0 };
+        std::atomic<size_t> limit{ no_limit };
+        uint64_t base{ 0 };
+    };
+
+    void wake_flusher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wanted = true;
+        }
+        m_flush_wanted.notify_one();
+    }
+
+    void flush_loop()
+    {
+        for (;;)
+        {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_flush_wanted.wait_for(lock, m_delay, [&] { return m_wanted || m_stop; });
+                m_wanted = false;
+                stopping = m_stop;
+            }
+
+            auto buffer(m_current.load(std::memory_order_acquire));
+            if (buffer->reserved.load(std::memory_order_acquire) == 0)
+            {
+                if (stopping)
+                    return;
+                continue;
+            }
+
+            // Seal the buffer, the bytes in it end where the last record that
+            // fit ends
+            auto size(buffer->reserved.exchange(sealed, std::memory_order_acq_rel));
+            if (size > m_capacity)
+            {
+                while ((size = buffer->limit.load(std::memory_order_acquire)) == no_limit)
+                    std::this_thread::yield();
+            }
+
+            auto next(buffer == &m_buffers[0] ? &m_buffers[1] : &m_buffers[0]);
+            next->base = buffer->base + size;
+            next->written.store(0, std::memory_order_relaxed);
+            next->limit.store(no_limit, std::memory_order_relaxed);
+            next->reserved.store(0, std::memory_order_release);
+            m_current.store(next, std::memory_order_release);
+
+            while (buffer->written.load(std::memory_order_acquire) != size)
+                std::this_thread::yield();
+
+            if (!write_batch(buffer->data.get(), size, buffer->base))
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_failed = true;
+                m_durable_changed.notify_all();
+                return;
+            }
+            ++m_batches;
+            m_commits.push_back({ buffer->base + size, std::chrono::steady_clock::now() });
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_durable.store(buffer->base + size, std::memory_order_release);
+            }
+            m_durable_changed.notify_all();
+        }
+    }
+
+    bool write_batch(char const* data, size_t size, uint64_t offset)
+    {
+        for (size_t done(0); done < size;)
+        {
+            auto const n(::pwrite(m_fd, data + done, size - done, offset + done));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+            {
+                m_error.assign(n < 0 ? errno : EIO, std::generic_category());
+                return false;
+            }
+            done += n;
+        }
+        if (::fdatasync(m_fd) != 0)
+        {
+            m_error.assign(errno, std::generic_category());
+            return false;
+        }
+        return true;
+    }
+
+    int m_fd;
+    size_t m_capacity;
+    std::chrono::microseconds m_delay;
+    Buffer m_buffers[2];
+    std::atomic<Buffer*> m_current{ nullptr };
+    std::atomic<uint64_t> m_durable{ 0 };
+    std::atomic<bool> m_failed{ false };
+    std::mutex m_mutex;
+    std::condition_variable m_flush_wanted;
+    std::condition_variable m_durable_changed;
+    bool m_wanted{ false };
+    bool m_stop{ false };
+    size_t m_batches{ 0 };
+    std::vector<Commit> m_commits;
+    std::error_code m_error;
+    std::thread m_flusher;
+};
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+#include <string>
+#include <H5Cpp.h>
+
+// File drivers of the single file HDF5 store
+enum class Hdf5Driver { sec2, core, direct };
+
+inline bool parse_hdf5_driver(std::string const& name, Hdf5Driver& driver)
+{
+    if (name == "sec2")
+        driver = Hdf5Driver::sec2;
+    else if (name == "core")
+        driver = Hdf5Driver::core;
+    else if (name == "direct")
+        driver = Hdf5Driver::direct;
+    else
+        return false;
+    return true;
+}
+
+inline bool hdf5_direct_supported()
+{
+#ifdef H5_HAVE_DIRECT
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Sizes are in bytes, 0 or less keeps the HDF5 default
+struct Hdf5Tuning
+{
+    Hdf5Driver driver{ Hdf5Driver::sec2 };
+    size_t page_size{ 0 };      // Paged aggregation with a page buffer of page_buffer bytes
+    size_t page_buffer{ 0 };
+    size_t meta_cache{ 0 };     // Metadata cache size
+    size_t meta_cache_max{ 0 }; // Upper bound of the adaptive metadata cache
+    size_t chunk_cache{ 0 };    // Raw data chunk cache size per dataset
+    size_t chunk_size{ 0 };     // Chunked blob datasets, contiguous when 0
+    size_t core_increment{ 64 * 1024 * 1024 };
+};
+
+inline H5::FileCreatPropList hdf5_create_props(Hdf5Tuning const& tuning, hsize_t userblock)
+{
+    H5::FileCreatPropList props;
+    if (tuning.page_size != 0)
+    {
+        // Pages are aligned to the page size, so the userblock grows to a page
+        if (userblock < tuning.page_size)
+            userblock = tuning.page_size;
+        H5Pset_file_space_strategy(props.getId(), H5F_FSPACE_STRATEGY_PAGE, 0, 1);
+        H5Pset_file_space_page_size(props.getId(), tuning.page_size);
+    }
+    props.setUserblock(userblock);
+    return props;
+}
+
+inline H5::FileAccPropList hdf5_access_props(Hdf5Tuning const& tuning)
+{
+    H5::FileAccPropList props;
+    switch (tuning.driver)
+    {
+    case Hdf5Driver::sec2:
+        props.setSec2();
+        break;
+    case Hdf5Driver::core:
+        // Everything in memory, written to the file when it is closed
+        props.setCore(tuning.core_increment, true);
+        break;
+    case Hdf5Driver::direct:
+#ifdef H5_HAVE_DIRECT
+        H5Pset_fapl_direct(props.getId(), 4096, 4096, 16 * 1024 * 1024);
+#endif
+        break;
+    }
+
+    if (tuning.page_size != 0 && tuning.page_buffer != 0)
+        H5Pset_page_buffer_size(props.getId(), tuning.page_buffer, 0, 0);
+
+    if (tuning.meta_cache != 0 || tuning.meta_cache_max != 0)
+    {
+        H5AC_cache_config_t config;
+        config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+        H5Pget_mdc_config(props.getId(), &config);
+        if (tuning.meta_cache != 0)
+        {
+            config.set_initial_size = true;
+            config.initial_size = tuning.meta_cache;
+            config.max_size = tuning.meta_cache > config.max_size ? tuning.meta_cache : config.max_size;
+            config.min_size = tuning.meta_cache < config.min_size ? tuning.meta_cache : config.min_size;
+        }
+        if (tuning.meta_cache_max != 0)
+        {
+            config.set_initial_size = true;
+            config.max_size = tuning.meta_cache_max;
+            config.initial_size = config.initial_size < config.max_size ? config.initial_size : config.max_size;
+            config.min_size = config.min_size < config.max_size ? config.min_size : config.max_size;
+        }
+        H5Pset_mdc_config(props.getId(), &config);
+    }
+    return props;
+}
+
+inline H5::DSetCreatPropList hdf5_dataset_create_props(Hdf5Tuning const& tuning, hsize_t size)
+{
+    H5::DSetCreatPropList props;
+    if (tuning.chunk_size != 0)
+    {
+        hsize_t chunk[1]{ tuning.chunk_size < size ? tuning.chunk_size : size };
+        props.setChunk(1, chunk);
+    }
+    return props;
+}
+
+inline H5::DSetAccPropList hdf5_dataset_access_props(Hdf5Tuning const& tuning)
+{
+    H5::DSetAccPropList props;
+    if (tuning.chunk_cache != 0)
+    {
+        // About 100 hash slots per chunk that fits in the cache
+        auto const chunks(tuning.chunk_size != 0 ? tuning.chunk_cache / tuning.chunk_size + 1 : 1);
+        props.setChunkCache(chunks * 100 + 1, tuning.chunk_cache, 0.75);
+    }
+    return props;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <sstream>
+#include <system_error>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+// Prefault page tables of an existing mapping, Linux 5.14 and later
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+#endif
+
+// Modes applied to the mappings of the mio backends, given as a comma
+// separated list, e.g. "populate,hugepage".
+struct MmapTuning
+{
+    bool populate{ false };   // Fault in the whole mapping up front, like MAP_POPULATE
+    bool sequential{ false }; // madvise(MADV_SEQUENTIAL)
+    bool willneed{ false };   // madvise(MADV_WILLNEED)
+    bool hugepage{ false };   // madvise(MADV_HUGEPAGE)
+    bool persistent{ false }; // One mapping of one file reused for all blobs
+
+    bool any_advice() const { return populate || sequential || willneed || hugepage; }
+};
+
+// False with the mode in unknown for a mode that is not known
+inline bool parse_mmap_tuning(std::string const& modes, MmapTuning& tuning, std::string& unknown)
+{
+    tuning = MmapTuning();
+    std::istringstream is(modes);
+    std::string mode;
+    while (std::getline(is, mode, ','))
+    {
+        if (mode.empty())
+            continue;
+        if (mode == "populate")
+            tuning.populate = true;
+        else if (mode == "sequential")
+            tuning.sequential = true;
+        else if (mode == "willneed")
+            tuning.willneed = true;
+        else if (mode == "hugepage")
+            tuning.hugepage = true;
+        else if (mode == "persistent")
+            tuning.persistent = true;
+        else
+        {
+            unknown = mode;
+            return false;
+        }
+    }
+    return true;
+}
+
+inline size_t page_size()
+{
+#ifdef __linux__
+    static size_t const size(::sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+// Apply the tuning advice to a page aligned mapping. The hints are best
+// effort, a file system that can't honour e.g. MADV_HUGEPAGE is not an error.
+inline void advise_mapping(char const* data, size_t length, MmapTuning const& tuning, bool write)
+{
+    if (length == 0 || !tuning.any_advice())
+        return;
+
+#ifdef __linux__
+    auto addr = const_cast<char*>(data);
+    if (tuning.hugepage)
+        ::madvise(addr, length, MADV_HUGEPAGE);
+    if (tuning.sequential)
+        ::madvise(addr, length, MADV_SEQUENTIAL);
+    if (tuning.willneed)
+        ::madvise(addr, length, MADV_WILLNEED);
+    if (tuning.populate && ::madvise(addr, length, write ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) != 0)
+    {
+        // Older kernel, touch every page instead
+        auto const step(page_size());
+        for (size_t offset(0); offset < length; offset += step)
+        {
+            if (write)
+                *static_cast<char volatile*>(addr + offset) = *static_cast<char volatile*>(addr + offset);
+            else
+                (void)*static_cast<char volatile const*>(addr + offset);
+        }
+    }
+#endif
+}
+
+// Flush [offset, offset + length) of a writable mapping to disk.
+inline void sync_range(char* data, size_t offset, size_t length, std::error_code& error)
+{
+#ifdef __linux__
+    auto const start(offset / page_size() * page_size());
+    if (::msync(data + start, offset + length - start, MS_SYNC) != 0)
+        error.assign(errno, std::generic_category());
+#elif defined(_WIN32)
+    if (!::FlushViewOfFile(data + offset, length))
+        error.assign(::GetLastError(), std::system_category());
+#else
+    (void)data; (void)offset; (void)length;
+    error = std::make_error_code(std::errc::not_supported);
+#endif
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+// Thread and memory placement on NUMA nodes, without a libnuma dependency.
+// On Linux memory is bound with the mbind system call. Windows can pin
+// threads to a node but can't move memory that is already allocated.
+
+// CPUs in a list like "0-3,8-11"
+inline std::vector<int> parse_cpu_list(std::string const& list)
+{
+    std::vector<int> cpus;
+    std::istringstream is(list);
+    std::string range;
+    while (std::getline(is, range, ','))
+    {
+        auto const dash(range.find('-'));
+        try
+        {
+            auto const first(std::stoi(range.substr(0, dash)));
+            auto const last(dash == std::string::npos ? first : std::stoi(range.substr(dash + 1)));
+            for (auto cpu(first); cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+        catch (std::exception const&)
+        {
+        }
+    }
+    return cpus;
+}
+
+inline int numa_nodes()
+{
+#ifdef __linux__
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (std::getline(online, list))
+    {
+        auto const nodes(parse_cpu_list(list));
+        if (!nodes.empty())
+            return nodes.back() + 1;
+    }
+#elif defined(_WIN32)
+    ULONG highest;
+    if (::GetNumaHighestNodeNumber(&highest))
+        return static_cast<int>(highest) + 1;
+#endif
+    return 1;
+}
+
+#ifdef __linux__
+inline std::vector<int> node_cpus(int node)
+{
+    std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    std::getline(cpulist, list);
+    return parse_cpu_list(list);
+}
+#endif
+
+// Pin the calling thread to the CPUs of a node, -1 for all CPUs
+inline bool pin_thread_to_node(int node)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (node < 0)
+    {
+        auto const cpus(::sysconf(_SC_NPROCESSORS_CONF));
+        for (auto cpu(0); cpu < cpus && cpu < CPU_SETSIZE; ++cpu)
+            CPU_SET(cpu, &set);
+    }
+    else
+    {
+        for (auto cpu : node_cpus(node))
+        {
+            if (cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        }
+        if (CPU_COUNT(&set) == 0)
+            return false;
+    }
+    return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    if (node < 0)
+        return true;
+    GROUP_AFFINITY affinity{};
+    return ::GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity)
+        && ::SetThreadGroupAffinity(::GetCurrentThread(), &affinity, nullptr);
+#else
+    return node < 0;
+#endif
+}
+
+// Node of the CPU the calling thread runs on
+inline int current_node()
+{
+#ifdef __linux__
+    unsigned cpu(0), node(0);
+    return ::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? static_cast<int>(node) : -1;
+#elif defined(_WIN32)
+    PROCESSOR_NUMBER processor;
+    ::GetCurrentProcessorNumberEx(&processor);
+    USHORT node;
+    return ::GetNumaProcessorNodeEx(&processor, &node) ? node : -1;
+#else
+    return -1;
+#endif
+}
+
+#ifdef __linux__
+namespace numa_detail
+{
+    int const mpol_bind = 2;              // MPOL_BIND
+    unsigned const mpol_mf_move = 1 << 1; // MPOL_MF_MOVE
+    int const mpol_f_node = 1 << 0;       // MPOL_F_NODE
+    int const mpol_f_addr = 1 << 1;       // MPOL_F_ADDR
+    size_t const max_nodes = 1024;
+
+    using NodeMask = unsigned long[max_nodes / (8 * sizeof(unsigned long))];
+}
+#endif
+
+// Bind the pages inside [data, data + size) to a node and move the pages
+// that are already there. Partial pages at the ends are left alone.
+inline bool bind_to_node(char* data, size_t size, int node)
+{
+#ifdef __linux__
+    using namespace numa_detail;
+
+    if (node < 0 || size_t(node) >= max_nodes)
+        return false;
+    auto const page(static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE)));
+    auto const begin((reinterpret_cast<uintptr_t>(data) + page - 1) / page * page);
+    auto const end((reinterpret_cast<uintptr_t>(data) + size) / page * page);
+    if (end <= begin)
+        return true;
+
+    NodeMask mask{};
+    mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    return ::syscall(SYS_mbind, begin, end - begin, mpol_bind, mask, max_nodes + 1, mpol_mf_move) == 0;
+#else
+    (void)data; (void)size; (void)node;
+    return false;
+#endif
+}
+
+// Node that holds the page of an address, -1 when unknown
+inline int memory_node(char const* data)
+{
+#ifdef __linux__
+    using namespace numa_detail;
+
+    int node(-1);
+    if (::syscall(SYS_get_mempolicy, &node, nullptr, 0, data, mpol_f_node | mpol_f_addr) != 0)
+        return -1;
+    return node;
+#else
+    (void)data;
+    return -1;
+#endif
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "timer.h"
+
+// Reads blobs [0, count) on background threads ahead of a consumer that
+// takes them in order. At most depth blobs are read ahead, each into one of
+// depth reusable buffers that the consumer hands back with release().
+class Prefetcher
+{
+public:
+    using Reader = std::function<bool(int, std::vector<char>&)>;
+
+    Prefetcher(Reader reader, int count, size_t blob_size, int depth, int threads)
+        : m_reader(std::move(reader)), m_count(count), m_slots(depth < 1 ? 1 : depth)
+    {
+        for (auto& slot : m_slots)
+            slot.data.resize(blob_size);
+        for (auto t(0); t < (threads < 1 ? 1 : threads); ++t)
+            m_threads.emplace_back(&Prefetcher::work, this);
+    }
+
+    ~Prefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_free.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    Prefetcher(Prefetcher const&) = delete;
+    Prefetcher& operator=(Prefetcher const&) = delete;
+
+    // Wait for blob i, nullptr when it couldn't be read
+    std::vector<char> const* acquire(int i)
+    {
+        auto& slot(m_slots[i % m_slots.size()]);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wait.start();
+        m_ready.wait(lock, [&] { return slot.ready && slot.blob == i; });
+        m_wait.stop();
+        return slot.ok ? &slot.data : nullptr;
+    }
+
+    // Give the buffer of blob i back for the blobs that follow
+    void release(int i)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& slot(m_slots[i % m_slots.size()]);
+            slot.ready = false;
+            slot.blob = -1;
+            ++m_released;
+        }
+        m_free.notify_all();
+    }
+
+    // Time the consumer spent waiting for blobs
+    double wait_seconds() { return m_wait.elapsedSeconds(); }
+
+private:
+    struct Slot
+    {
+        int blob{ -1 };
+        bool ready{ false };
+        bool ok{ false };
+        std::vector<char> data;
+    };
+
+    void work()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_free.wait(lock, [&]
+            {
+                return m_stop || m_next >= m_count || m_next < m_released + int(m_slots.size());
+            });
+            if (m_stop || m_next >= m_count)
+                return;
+            auto const i(m_next++);
+            auto& slot(m_slots[i % m_slots.size()]);
+            lock.unlock();
+
+            // A reader that throws would terminate the process on this thread
+            bool ok(false);
+            try
+            {
+                ok = m_reader(i, slot.data);
+            }
+            catch (...)
+            {
+            }
+
+            lock.lock();
+            slot.blob = i;
+            slot.ok = ok;
+            slot.ready = true;
+            lock.unlock();
+            m_ready.notify_all();
+        }
+    }
+
+    Reader m_reader;
+    int m_count;
+    std::vector<Slot> m_slots;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_free;
+    int m_next{ 0 };
+    int m_released{ 0 };
+    bool m_stop{ false };
+    Timer m_wait;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Field layout of a record, taken at compile time from the serialize
+// function cereal uses. The record must be trivially copyable, its
+// serialize function constexpr, and the fields it archives must follow each
+// other without padding so each field is one chunk of the record on disk.
+namespace schema_detail
+{
+    size_t const max_fields = 64;
+
+    struct Layout
+    {
+        size_t count{ 0 };
+        size_t sizes[max_fields]{};
+    };
+
+    // Archive that notes the size of each field instead of storing it
+    class LayoutArchive
+    {
+    public:
+        constexpr explicit LayoutArchive(Layout& layout) : m_layout(layout) {}
+
+        template<class... Fields>
+        constexpr LayoutArchive& operator()(Fields&... fields)
+        {
+            (add(fields), ...);
+            return *this;
+        }
+
+    private:
+        template<class Field>
+        constexpr void add(Field const&)
+        {
+            static_assert(std::is_trivially_copyable<Field>::value, "record fields must be trivially copyable");
+            m_layout.sizes[m_layout.count++] = sizeof(Field);
+        }
+
+        Layout& m_layout;
+    };
+
+    template<class Record>
+    constexpr Layout layout()
+    {
+        Layout layout{};
+        Record record{};
+        LayoutArchive archive(layout);
+        record.serialize(archive);
+        return layout;
+    }
+
+    template<size_t N, size_t... I>
+    constexpr std::array<size_t, N> sizes(Layout const& layout, std::index_sequence<I...>)
+    {
+        return { { layout.sizes[I]... } };
+    }
+
+    template<size_t N>
+    constexpr std::array<size_t, N> offsets(std::array<size_t, N> const& sizes)
+    {
+        std::array<size_t, N> offsets{};
+        size_t offset(0);
+        for (size_t i(0); i != N; ++i)
+        {
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
+        return offsets;
+    }
+
+    template<size_t N>
+    constexpr size_t total(std::array<size_t, N> const& sizes)
+    {
+        size_t total(0);
+        for (size_t i(0); i != N; ++i)
+            total += sizes[i];
+        return total;
+    }
+}
+
+template<class Record>
+struct RecordSchema
+{
+    static_assert(std::is_trivially_copyable<Record>::value, "records must be trivially copyable");
+
+    static constexpr schema_detail::Layout layout = schema_detail::layout<Record>();
+    static constexpr size_t fields = layout.count;
+    static constexpr std::array<size_t, fields> sizes = schema_detail::sizes<fields>(layout, std::make_index_sequence<fields>());
+    static constexpr std::array<size_t, fields> offsets = schema_detail::offsets(sizes);
+    static constexpr size_t size = sizeof(Record);
+
+    static_assert(fields != 0, "serialize archives no fields");
+    static_assert(schema_detail::total(sizes) == size, "the fields must cover the record without padding");
+};
+
+// One buffer per field of a record, field i filled with '1' + i
+template<class Record>
+std::array<std::vector<char>, RecordSchema<Record>::fields> make_record_chunks()
+{
+    std::array<std::vector<char>, RecordSchema<Record>::fields> chunks;
+    for (size_t i(0); i != chunks.size(); ++i)
+        chunks[i].assign(RecordSchema<Record>::sizes[i], char('1' + i));
+    return chunks;
+}
+
+// Calls f with a RecordType<Record> for each record type of a list
+template<class Record>
+struct RecordType
+{
+    using type = Record;
+};
+
+template<class... Records>
+struct RecordTypes
+{
+    template<class F>
+    static void for_each(F&& f)
+    {
+        (f(RecordType<Records>()), ...);
+    }
+};
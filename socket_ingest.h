@@ -0,0 +1,142 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#endif
+
+// Loopback connections and transfers of the ingest benchmark. A blob on the
+// wire is an IngestHeader followed by size bytes.
+enum class IngestTransport { tcp, unix_socket };
+
+struct IngestHeader
+{
+    uint64_t size;
+    int64_t sent_ns; // steady_clock time the producer started sending
+};
+
+#ifdef __linux__
+// A connected pair of stream sockets, over 127.0.0.1 or a Unix socket pair
+inline bool connect_loopback(IngestTransport transport, int& producer, int& consumer, std::error_code& error)
+{
+    producer = consumer = -1;
+    if (transport == IngestTransport::unix_socket)
+    {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            error.assign(errno, std::generic_category());
+            return false;
+        }
+        producer = fds[0];
+        consumer = fds[1];
+        return true;
+    }
+
+    auto const fail = [&](int listener)
+    {
+        error.assign(errno, std::generic_category());
+        for (auto fd : { listener, producer, consumer })
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+        producer = consumer = -1;
+        return false;
+    };
+
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+        return fail(listener);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length(sizeof(address));
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listener, 1) != 0
+        || ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+        return fail(listener);
+
+    producer = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (producer < 0 || ::connect(producer, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        return fail(listener);
+    consumer = ::accept(listener, nullptr, nullptr);
+    if (consumer < 0)
+        return fail(listener);
+    ::close(listener);
+
+    int one(1);
+    ::setsockopt(producer, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return true;
+}
+
+inline bool send_all(int fd, char const* data, size_t size)
+{
+    while (size != 0)
+    {
+        auto const n(::send(fd, data, size, MSG_NOSIGNAL));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+inline bool recv_all(int fd, char* data, size_t size)
+{
+    while (size != 0)
+    {
+        auto const n(::recv(fd, data, size, MSG_WAITALL));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Move size bytes from a socket to a file at offset through a pipe, the
+// data stays in kernel pages and is never copied to user space
+inline bool splice_to_file(int socket, int const pipe[2], int file, size_t size, std::error_code& error)
+{
+    loff_t offset(0);
+    while (size != 0)
+    {
+        auto const in(::splice(socket, nullptr, pipe[1], nullptr, size, SPLICE_F_MOVE | SPLICE_F_MORE));
+        if (in < 0 && errno == EINTR)
+            continue;
+        if (in <= 0)
+        {
+            error = in == 0 ? std::make_error_code(std::errc::connection_reset) : std::error_code(errno, std::generic_category());
+            return false;
+        }
+        for (auto left(in); left != 0;)
+        {
+            auto const out(::splice(pipe[0], nullptr, file, &offset, left, SPLICE_F_MOVE | SPLICE_F_MORE));
+            if (out < 0 && errno == EINTR)
+                continue;
+            if (out <= 0)
+            {
+                error.assign(out == 0 ? EIO : errno, std::generic_category());
+                return false;
+            }
+            left -= out;
+        }
+        size -= in;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Value below which a fraction p of the values are
+inline double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    auto const k(std::min(values.size() - 1, static_cast<size_t>(p * values.size())));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// Throughput and latency percentiles of a long running test, one row per
+// interval in a CSV file. An interval is a stall when a blob in it took
+// longer than the stall threshold, or when no blob completed at all.
+class ThroughputSeries
+{
+public:
+    ThroughputSeries(std::string const& file_name, double interval_secs, double stall_ms, size_t blob_size)
+        : m_file(file_name, std::ios::trunc), m_interval(interval_secs), m_stall_ms(stall_ms), m_blob_size(blob_size),
+        m_start(std::chrono::steady_clock::now()), m_interval_end(m_interval)
+    {
+        m_file << "seconds,blobs,MB/s,p50_ms,p99_ms,max_ms,stall\n";
+    }
+
+    // A blob completed now after latency_ms, returns whether each of the
+    // intervals closed by it was a stall
+    std::vector<bool> const& record(double latency_ms)
+    {
+        m_closed.clear();
+        close_intervals(elapsed());
+        m_latencies.push_back(latency_ms);
+        return m_closed;
+    }
+
+    // Close the last, partial interval
+    void finish()
+    {
+        auto const now(elapsed());
+        close_intervals(now);
+        if (!m_latencies.empty())
+            emit(now - (m_interval_end - m_interval), now);
+    }
+
+    int intervals() const { return static_cast<int>(m_throughput.size()); }
+    int stalls() const { return m_stalls; }
+
+    double min_throughput() const { return m_throughput.empty() ? 0.0 : *std::min_element(m_throughput.begin(), m_throughput.end()); }
+    double max_throughput() const { return m_throughput.empty() ? 0.0 : *std::max_element(m_throughput.begin(), m_throughput.end()); }
+
+    // Coefficient of variation of the interval throughput
+    double throughput_cv() const
+    {
+        if (m_throughput.size() < 2)
+            return 0.0;
+        double sum(0.0), sum2(0.0);
+        for (auto t : m_throughput)
+        {
+            sum += t;
+            sum2 += t * t;
+        }
+        auto const n(double(m_throughput.size()));
+        auto const mean(sum / n);
+        return mean != 0.0 ? std::sqrt(std::max(0.0, sum2 / n - mean * mean)) / mean : 0.0;
+    }
+
+private:
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    void close_intervals(double now)
+    {
+        while (now >= m_interval_end)
+        {
+            emit(m_interval, m_interval_end);
+            m_interval_end += m_interval;
+        }
+    }
+
+    // A row for the secs up to at
+    void emit(double secs, double at)
+    {
+        auto const blobs(m_latencies.size());
+        auto const max_ms(blobs != 0 ? *std::max_element(m_latencies.begin(), m_latencies.end()) : 0.0);
+        auto const throughput(secs > 0.0 ? blobs * (m_blob_size / 1048576.0) / secs : 0.0);
+        auto const stalled(blobs == 0 || max_ms > m_stall_ms);
+        if (stalled)
+            ++m_stalls;
+        m_closed.push_back(stalled);
+        m_throughput.push_back(throughput);
+
+        m_file << at << ',' << blobs << ',' << throughput << ','
+            << percentile(m_latencies, 0.5) << ',' << percentile(m_latencies, 0.99) << ',' << max_ms << ','
+            << (stalled ? 1 : 0) << std::endl;
+        m_latencies.clear();
+    }
+
+    std::ofstream m_file;
+    double m_interval;
+    double m_stall_ms;
+    size_t m_blob_size;
+    std::chrono::steady_clock::time_point m_start;
+    double m_interval_end;
+    std::vector<double> m_latencies;
+    std::vector<double> m_throughput;
+    std::vector<bool> m_closed; // Stall flags of the intervals the last record closed
+    int m_stalls{ 0 };
+};
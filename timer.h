@@ -9,12 +9,12 @@ public:
 
     void start()
     {
-        m_start = std::chrono::high_resolution_clock::now();
+        m_start = std::chrono::steady_clock::now();
     }
 
     void stop()
     {
-        auto now(std::chrono::high_resolution_clock::now());
+        auto now(std::chrono::steady_clock::now());
         m_elapsed += now - m_start;
     }
 
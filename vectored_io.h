@@ -0,0 +1,114 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <sstream>
+#include <system_error>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+// Settings of the scatter/gather backend. The RWF_ flags are given as a
+// comma separated list, e.g. "dsync,hipri", and need preadv2/pwritev2.
+struct VectoredTuning
+{
+    int batch{ 1024 }; // iovecs per preadv/pwritev call
+    int flags{ 0 };    // RWF_ flags
+};
+
+// False with the name in unknown for a flag that is not known, or not
+// available on this system
+inline bool parse_rwf_flags(std::string const& names, int& flags, std::string& unknown)
+{
+    flags = 0;
+    std::istringstream is(names);
+    std::string name;
+    while (std::getline(is, name, ','))
+    {
+        if (name.empty())
+            continue;
+#ifdef RWF_HIPRI
+        if (name == "hipri")
+            flags |= RWF_HIPRI;
+        else if (name == "dsync")
+            flags |= RWF_DSYNC;
+        else if (name == "sync")
+            flags |= RWF_SYNC;
+        else if (name == "nowait")
+            flags |= RWF_NOWAIT;
+        else
+#endif
+        {
+            unknown = name;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Largest number of iovecs the kernel takes in one call
+inline int iov_max()
+{
+#ifdef __linux__
+    static int const max(static_cast<int>(::sysconf(_SC_IOV_MAX)));
+    return max > 0 ? max : 1024;
+#else
+    return 1024;
+#endif
+}
+
+#ifdef __linux__
+// Transfer all of iov at offset, the rest of a short transfer is resubmitted.
+// iov is consumed. A read stops early at the end of the file.
+inline size_t transfer_vectored(int fd, iovec* iov, int n, off_t offset, int flags, bool write, std::error_code& error)
+{
+    size_t total(0);
+    while (n > 0)
+    {
+        ssize_t done;
+        if (flags != 0)
+            done = write ? ::pwritev2(fd, iov, n, offset, flags) : ::preadv2(fd, iov, n, offset, flags);
+        else
+            done = write ? ::pwritev(fd, iov, n, offset) : ::preadv(fd, iov, n, offset);
+
+        if (done < 0)
+        {
+            if (errno == EINTR)
+                continue;
+#ifdef RWF_NOWAIT
+            // Not in the page cache, wait for it after all
+            if (errno == EAGAIN && (flags & RWF_NOWAIT) != 0)
+            {
+                flags &= ~RWF_NOWAIT;
+                continue;
+            }
+#endif
+            error.assign(errno, std::generic_category());
+            return total;
+        }
+        if (done == 0)
+        {
+            if (write)
+                error = std::make_error_code(std::errc::io_error);
+            return total;
+        }
+
+        offset += done;
+        total += done;
+        auto left(static_cast<size_t>(done));
+        while (n > 0 && left >= iov->iov_len)
+        {
+            left -= iov->iov_len;
+            ++iov;
+            --n;
+        }
+        if (n > 0)
+        {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+    return total;
+}
+#endif
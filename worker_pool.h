@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads that stay around between batches of work, so a test that fans out
+// per blob doesn't pay for thread creation inside its timer. run() splits
+// [0, count) in one slice per thread, calls body on each slice and returns
+// when all of them are done. init is called on each thread when it starts.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int threads, std::function<void(int)> init = nullptr)
+        : m_size(threads < 1 ? 1 : threads), m_init(std::move(init))
+    {
+        for (auto t(0); t != m_size; ++t)
+            m_threads.emplace_back(&WorkerPool::work, this, t);
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+
+    void run(int count, std::function<void(int, int)> const& body)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_body = &body;
+        m_count = count;
+        m_pending = m_size;
+        ++m_generation;
+        m_start.notify_all();
+        m_done.wait(lock, [&] { return m_pending == 0; });
+        m_body = nullptr;
+    }
+
+private:
+    void work(int index)
+    {
+        if (m_init)
+            m_init(index);
+
+        unsigned generation(0);
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop)
+                return;
+            generation = m_generation;
+            auto const& body(*m_body);
+            auto const per_thread((m_count + m_size - 1) / m_size);
+            auto const begin(std::min(m_count, index * per_thread));
+            auto const end(std::min(m_count, begin + per_thread));
+            lock.unlock();
+
+            if (begin < end)
+                body(begin, end);
+
+            lock.lock();
+            if (--m_pending == 0)
+                m_done.notify_one();
+        }
+    }
+
+    int const m_size;
+    std::function<void(int)> m_init;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    std::function<void(int, int)> const* m_body{ nullptr };
+    int m_count{ 0 };
+    int m_pending{ 0 };
+    unsigned m_generation{ 0 };
+    bool m_stop{ false };
+};